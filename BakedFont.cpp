@@ -0,0 +1,186 @@
+#include "BakedFont.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <cassert>
+#include <fstream>
+#include <stdexcept>
+#include <streambuf>
+
+//istream-compatible view of a block of memory, so read_chunk can parse the file without copying it again:
+struct MemoryBuffer : std::streambuf {
+	MemoryBuffer(char *begin, size_t size) {
+		setg(begin, begin, begin + size);
+	}
+};
+
+BakedFont::BakedFont(std::string const &filename) {
+	//read the whole file with one read:
+	std::vector< char > data;
+	{
+		std::ifstream file(filename, std::ios::binary | std::ios::ate);
+		if (!file) {
+			throw std::runtime_error("Failed to open baked font '" + filename + "'.");
+		}
+		std::streamsize size = file.tellg();
+		file.seekg(0, std::ios::beg);
+		data.resize(size_t(size));
+		if (!file.read(data.data(), size)) {
+			throw std::runtime_error("Failed to read baked font '" + filename + "'.");
+		}
+	}
+
+	MemoryBuffer buffer(data.data(), data.size());
+	std::istream from(&buffer);
+
+	std::vector< Header > headers;
+	read_chunk(from, "bfn0", &headers);
+	if (headers.size() != 1) {
+		throw std::runtime_error("Baked font '" + filename + "' should have exactly one header.");
+	}
+	header = headers[0];
+
+	read_chunk(from, "pix0", &pixels);
+	if (pixels.size() != size_t(header.atlas_width) * size_t(header.atlas_height)) {
+		throw std::runtime_error("Baked font '" + filename + "' has the wrong number of pixels.");
+	}
+
+	read_chunk(from, "gly0", &glyphs);
+	read_chunk(from, "cmp0", &codepoints);
+	read_chunk(from, "lig0", &ligatures);
+	read_chunk(from, "krn0", &kerning);
+
+	for (auto const &glyph : glyphs) {
+		if (glyph.origin.x + glyph.size.x > header.atlas_width || glyph.origin.y + glyph.size.y > header.atlas_height) {
+			throw std::runtime_error("Baked font '" + filename + "' has a glyph outside its atlas.");
+		}
+	}
+
+	build_lookup();
+
+	//every referenced glyph should have been baked:
+	for (auto const &cp : codepoints) {
+		if (!glyph_lookup.count(cp.index)) throw std::runtime_error("Baked font '" + filename + "' maps a codepoint to a missing glyph.");
+	}
+	for (auto const &lig : ligatures) {
+		if (!glyph_lookup.count(lig.index)) throw std::runtime_error("Baked font '" + filename + "' has a ligature with a missing glyph.");
+	}
+}
+
+void BakedFont::save(std::string const &filename) const {
+	std::ofstream file(filename, std::ios::binary);
+
+	write_chunk("bfn0", std::vector< Header >{ header }, &file);
+	write_chunk("pix0", pixels, &file);
+	write_chunk("gly0", glyphs, &file);
+	write_chunk("cmp0", codepoints, &file);
+	write_chunk("lig0", ligatures, &file);
+	write_chunk("krn0", kerning, &file);
+
+	if (!file) {
+		throw std::runtime_error("Failed to write baked font '" + filename + "'.");
+	}
+}
+
+void BakedFont::build_lookup() {
+	glyph_lookup.clear();
+	for (uint32_t i = 0; i < glyphs.size(); ++i) {
+		glyph_lookup.emplace(glyphs[i].index, i);
+	}
+	codepoint_lookup.clear();
+	for (auto const &cp : codepoints) {
+		codepoint_lookup.emplace(cp.codepoint, cp.index);
+	}
+	ligature_lookup.clear();
+	for (auto const &lig : ligatures) {
+		ligature_lookup.emplace(pair_key(lig.first, lig.second), lig.index);
+	}
+	kerning_lookup.clear();
+	for (auto const &kern : kerning) {
+		kerning_lookup.emplace(pair_key(kern.first, kern.second), kern.x_advance);
+	}
+}
+
+//decode UTF-8 'text' into codepoints (and the byte offset each starts at); returns false on malformed input:
+static bool decode_utf8(std::string_view text, std::vector< uint32_t > *codepoints_, std::vector< uint32_t > *offsets_) {
+	assert(codepoints_);
+	auto &codepoints = *codepoints_;
+	assert(offsets_);
+	auto &offsets = *offsets_;
+	codepoints.clear();
+	codepoints.reserve(text.size());
+	offsets.clear();
+	offsets.reserve(text.size());
+
+	for (size_t i = 0; i < text.size(); /* later */) {
+		uint8_t c = uint8_t(text[i]);
+		uint32_t count = 0;
+		uint32_t cp = 0;
+		if (c < 0x80) { count = 0; cp = c; }
+		else if ((c & 0xe0) == 0xc0) { count = 1; cp = c & 0x1f; }
+		else if ((c & 0xf0) == 0xe0) { count = 2; cp = c & 0x0f; }
+		else if ((c & 0xf8) == 0xf0) { count = 3; cp = c & 0x07; }
+		else return false;
+		if (i + 1 + count > text.size()) return false;
+		for (uint32_t j = 1; j <= count; ++j) {
+			uint8_t b = uint8_t(text[i + j]);
+			if ((b & 0xc0) != 0x80) return false;
+			cp = (cp << 6) | (b & 0x3f);
+		}
+		codepoints.emplace_back(cp);
+		offsets.emplace_back(uint32_t(i));
+		i += 1 + count;
+	}
+	return true;
+}
+
+bool BakedFont::shape(std::string_view text, ShapeCache::Run *run_) const {
+	assert(run_);
+	auto &run = *run_;
+	run.clear();
+
+	std::vector< uint32_t > cps, offsets;
+	if (!decode_utf8(text, &cps, &offsets)) return false;
+
+	run.reserve(cps.size());
+	for (size_t i = 0; i < cps.size(); /* later */) {
+		uint32_t cluster = offsets[i];
+		uint32_t index;
+		//two-character ligature?
+		auto lig = (i + 1 < cps.size() ? ligature_lookup.find(pair_key(cps[i], cps[i+1])) : ligature_lookup.end());
+		if (lig != ligature_lookup.end()) {
+			index = lig->second;
+			i += 2;
+		} else {
+			auto f = codepoint_lookup.find(cps[i]);
+			if (f == codepoint_lookup.end()) return false;
+			index = f->second;
+			i += 1;
+		}
+
+		//kern against the previous glyph:
+		if (!run.empty()) {
+			auto k = kerning_lookup.find(pair_key(run.back().index, index));
+			if (k != kerning_lookup.end()) run.back().advance.x += k->second;
+		}
+
+		GlyphEntry const &glyph = glyphs[glyph_lookup.at(index)];
+		run.emplace_back(ShapeCache::Glyph{ index, glyph.advance, glm::ivec2(0), cluster });
+	}
+
+	return true;
+}
+
+bool BakedFont::seed(GlyphAtlas *atlas_, uint32_t key_base) const {
+	assert(atlas_);
+	auto &atlas = *atlas_;
+
+	glm::uvec2 origin;
+	if (!atlas.insert_block(glm::uvec2(header.atlas_width, header.atlas_height), pixels.data(), &origin)) {
+		return false;
+	}
+	for (auto const &glyph : glyphs) {
+		atlas.insert_placed(key_base + glyph.index, origin + glyph.origin, glyph.size, glyph.bearing, glyph.advance);
+	}
+	return true;
+}
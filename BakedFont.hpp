@@ -0,0 +1,111 @@
+#pragma once
+
+/*
+ * A BakedFont is everything needed to draw text in one font at one size,
+ *  prepared ahead of time by the 'bake-font' tool so the game doesn't need
+ *  FreeType or HarfBuzz to start up:
+ *   - a pre-packed glyph atlas image of signed distance fields (see make_sdf.hpp)
+ *   - per-glyph placement metrics
+ *   - a codepoint -> glyph table, two-character ligatures, and pair kerning
+ *
+ * The file is a sequence of chunks in the read_write_chunk.hpp format:
+ *   "bfn0" - one Header
+ *   "pix0" - atlas pixels (atlas_width * atlas_height bytes, row 0 at top)
+ *   "gly0" - GlyphEntry per baked glyph
+ *   "cmp0" - CodepointEntry per mapped codepoint
+ *   "lig0" - LigatureEntry per ligature
+ *   "krn0" - KerningEntry per pair with non-zero kerning
+ *
+ * Shaping with these tables is only an approximation of HarfBuzz (no
+ *  contextual features beyond pairs), but is exact for the kind of short
+ *  Latin strings the game draws.
+ *
+ */
+
+#include "GlyphAtlas.hpp"
+#include "ShapeCache.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct BakedFont {
+	//empty font (shape() always fails):
+	BakedFont() = default;
+	//read from a file written by save() (throws on error):
+	BakedFont(std::string const &filename);
+
+	//write to a file (throws on error):
+	void save(std::string const &filename) const;
+
+	struct Header {
+		uint32_t glyph_size = 0; //glyphs were rasterized (and advances measured) at this size, in pixels
+		uint32_t spread = 0; //distance field range, in pixels (see make_sdf.hpp)
+		uint32_t atlas_width = 0;
+		uint32_t atlas_height = 0;
+		//vertical metrics at glyph_size, in 26.6 fixed point (as in FT_Size_Metrics):
+		int32_t ascender = 0; //baseline to top of tallest glyphs (positive)
+		int32_t descender = 0; //baseline to bottom of lowest glyphs (negative)
+		int32_t line_height = 0; //baseline-to-baseline distance
+	};
+	static_assert(sizeof(Header) == 28, "Header is packed.");
+
+	struct GlyphEntry {
+		uint32_t index = 0; //glyph index in font
+		glm::uvec2 origin = glm::uvec2(0); //upper-left pixel of bitmap in atlas
+		glm::uvec2 size = glm::uvec2(0); //size of bitmap in pixels
+		glm::ivec2 bearing = glm::ivec2(0); //offset from pen position to upper-left of bitmap, in pixels
+		glm::ivec2 advance = glm::ivec2(0); //pen movement after this glyph, in 26.6 fixed point
+	};
+	static_assert(sizeof(GlyphEntry) == 36, "GlyphEntry is packed.");
+
+	struct CodepointEntry {
+		uint32_t codepoint = 0;
+		uint32_t index = 0;
+	};
+	static_assert(sizeof(CodepointEntry) == 8, "CodepointEntry is packed.");
+
+	struct LigatureEntry {
+		uint32_t first = 0, second = 0; //codepoints
+		uint32_t index = 0; //glyph that replaces them
+	};
+	static_assert(sizeof(LigatureEntry) == 12, "LigatureEntry is packed.");
+
+	struct KerningEntry {
+		uint32_t first = 0, second = 0; //glyph indices
+		int32_t x_advance = 0; //added to the advance of 'first' when followed by 'second', in 26.6 fixed point
+	};
+	static_assert(sizeof(KerningEntry) == 12, "KerningEntry is packed.");
+
+	Header header;
+	std::vector< uint8_t > pixels;
+	std::vector< GlyphEntry > glyphs;
+	std::vector< CodepointEntry > codepoints;
+	std::vector< LigatureEntry > ligatures;
+	std::vector< KerningEntry > kerning;
+
+	//shape UTF-8 'text' into 'run' using the baked tables:
+	// returns false if 'text' uses a codepoint that wasn't baked (caller should fall back to HarfBuzz).
+	bool shape(std::string_view text, ShapeCache::Run *run) const;
+
+	//copy the baked image and glyph metrics into 'atlas', with each glyph keyed by 'key_base + glyph index':
+	// returns false if the atlas doesn't have room for the image.
+	bool seed(GlyphAtlas *atlas, uint32_t key_base = 0) const;
+
+	//--- internals ---
+
+	//lookup tables built from the arrays above by build_lookup():
+	std::unordered_map< uint32_t, uint32_t > glyph_lookup; //glyph index -> position in 'glyphs'
+	std::unordered_map< uint32_t, uint32_t > codepoint_lookup; //codepoint -> glyph index
+	std::unordered_map< uint64_t, uint32_t > ligature_lookup; //(first, second) codepoints -> glyph index
+	std::unordered_map< uint64_t, int32_t > kerning_lookup; //(first, second) glyph indices -> x_advance adjustment
+	void build_lookup();
+
+	static uint64_t pair_key(uint32_t first, uint32_t second) {
+		return (uint64_t(first) << 32) | uint64_t(second);
+	}
+};
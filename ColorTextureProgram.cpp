@@ -33,7 +33,7 @@ ColorTextureProgram::ColorTextureProgram() {
 	// this is very useful for writing long shader programs inline.
 
 	//look up the locations of vertex attributes:
-	vertex_vec4 = glGetAttribLocation(program, "Position");
+	vertex_vec4 = glGetAttribLocation(program, "vertex");
 	TexCoords_vec2 = glGetAttribLocation(program, "TexCoords");
 
 	//look up the locations of uniforms:
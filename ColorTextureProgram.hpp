@@ -10,7 +10,7 @@ struct ColorTextureProgram {
 
 	GLuint program = 0;
 	//Attribute (per-vertex variable) locations:
-	GLuint vertex_vec4 = -1U;
+	GLuint vertex_vec4 = -1U; //xy = position, zw = texcoord
 	GLuint TexCoords_vec2 = -1U;
 	//Uniform (per-invocation variable) locations:
 	GLuint projection_mat4 = -1U;
@@ -0,0 +1,98 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+
+//directory holding 'path' (for inotify to watch):
+static std::string directory_of(std::string const &path) {
+	std::string dir = std::filesystem::path(path).parent_path().string();
+	return dir.empty() ? "." : dir;
+}
+
+FileWatcher::FileWatcher(std::vector< std::string > const &paths_) : paths(paths_) {
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd < 0) throw std::runtime_error(std::string("Failed to start inotify: ") + std::strerror(errno));
+	for (std::string const &path : paths) {
+		//(adding the same directory again returns the same watch)
+		int wd = inotify_add_watch(fd, directory_of(path).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (wd < 0) {
+			std::string err = std::strerror(errno);
+			close(fd);
+			throw std::runtime_error("Failed to watch the directory of '" + path + "': " + err);
+		}
+		watches.emplace_back(wd);
+	}
+}
+
+FileWatcher::~FileWatcher() {
+	if (fd >= 0) close(fd);
+}
+
+std::vector< std::string > FileWatcher::poll() {
+	std::vector< std::string > changed;
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t got = read(fd, buffer, sizeof(buffer));
+		if (got <= 0) break; //(EAGAIN: nothing more to read)
+		for (char const *at = buffer; at < buffer + got; ) {
+			inotify_event const *event = reinterpret_cast< inotify_event const * >(at);
+			at += sizeof(inotify_event) + event->len;
+			if (event->len == 0) continue;
+			std::string name = event->name; //(name is zero-padded)
+			for (uint32_t i = 0; i < paths.size(); ++i) {
+				if (watches[i] != event->wd) continue;
+				if (std::filesystem::path(paths[i]).filename() != name) continue;
+				if (std::find(changed.begin(), changed.end(), paths[i]) == changed.end()) {
+					changed.emplace_back(paths[i]);
+				}
+			}
+		}
+	}
+	return changed;
+}
+
+#else
+
+//modification time of 'path' (or the oldest time, if it can't be read):
+static std::filesystem::file_time_type write_time(std::string const &path) {
+	std::error_code ec;
+	auto time = std::filesystem::last_write_time(path, ec);
+	return ec ? std::filesystem::file_time_type::min() : time;
+}
+
+FileWatcher::FileWatcher(std::vector< std::string > const &paths_) : paths(paths_) {
+	for (std::string const &path : paths) {
+		times.emplace_back(write_time(path));
+	}
+	next_poll = std::chrono::steady_clock::now();
+}
+
+FileWatcher::~FileWatcher() {
+}
+
+std::vector< std::string > FileWatcher::poll() {
+	std::vector< std::string > changed;
+	auto now = std::chrono::steady_clock::now();
+	if (now < next_poll) return changed;
+	next_poll = now + std::chrono::duration_cast< std::chrono::steady_clock::duration >(std::chrono::duration< float >(PollInterval));
+
+	for (uint32_t i = 0; i < paths.size(); ++i) {
+		auto time = write_time(paths[i]);
+		if (time != times[i]) {
+			times[i] = time;
+			changed.emplace_back(paths[i]);
+		}
+	}
+	return changed;
+}
+
+#endif
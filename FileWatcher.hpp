@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ * FileWatcher notices when files change on disk (e.g., to reload data
+ *  while the game runs).
+ *
+ * On Linux it uses inotify on the files' directories, so a poll() with
+ *  nothing to report is one non-blocking read(). Elsewhere it checks the
+ *  files' modification times, at most every PollInterval seconds.
+ *
+ * Editors and tools often save by writing a temporary file and renaming
+ *  it over the original; watching directories (rather than the files
+ *  themselves) catches that, too.
+ *
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct FileWatcher {
+	//watch 'paths' (which need not exist yet); throws on error:
+	FileWatcher(std::vector< std::string > const &paths);
+	~FileWatcher();
+
+	FileWatcher(FileWatcher const &) = delete;
+	FileWatcher &operator=(FileWatcher const &) = delete;
+
+	//paths (as passed to the constructor) that were written since the last call:
+	// (cheap enough to call every frame; doesn't allocate when nothing changed)
+	std::vector< std::string > poll();
+
+	static constexpr float PollInterval = 0.5f;
+
+	//--- internals ---
+	std::vector< std::string > paths;
+	#if defined(__linux__)
+	int fd = -1; //inotify instance
+	std::vector< int > watches; //watch descriptor of each path's directory
+	#else
+	std::vector< std::filesystem::file_time_type > times; //last seen modification time of each path
+	std::chrono::steady_clock::time_point next_poll;
+	#endif
+};
@@ -0,0 +1,190 @@
+#include "FontManager.hpp"
+
+#include "data_path.hpp"
+#include "make_sdf.hpp"
+
+#include <iostream>
+#include <stdexcept>
+
+Load< FontManager > fonts(LoadTagEarly);
+
+//file names (without extension) for each style, in Style order:
+static std::array< char const *, FontManager::StyleCount > const StyleFiles = {
+	"PTSerif-Regular",
+	"PTSerif-Bold",
+	"PTSerif-Italic",
+	"PTSerif-BoldItalic",
+};
+
+FontManager::FontManager() : atlas(glm::uvec2(1024, 1024), glm::uvec2(1024, 2048)) {
+	//read baked fonts (glyphs + shaping tables made offline by 'bake-font'; see Maekfile.js):
+	for (uint32_t s = 0; s < StyleCount; ++s) {
+		Face &face = faces[s];
+		face.ttf = data_path(std::string(StyleFiles[s]) + ".ttf");
+		try {
+			face.baked = BakedFont(data_path(std::string(StyleFiles[s]) + ".atlas"));
+			if (face.baked.header.glyph_size != GlyphSize || face.baked.header.spread != GlyphSpread) {
+				std::cerr << "WARNING: baked font for " << StyleFiles[s] << " has glyph size " << face.baked.header.glyph_size << " and spread " << face.baked.header.spread
+				          << " (expected " << GlyphSize << " and " << GlyphSpread << "); ignoring it." << std::endl;
+				face.baked = BakedFont();
+			}
+		} catch (std::exception &e) {
+			std::cerr << "WARNING: " << e.what() << " Text in " << StyleFiles[s] << " will be rasterized with FreeType as needed." << std::endl;
+			face.baked = BakedFont();
+		}
+	}
+
+	reset_atlas();
+
+	//vertical metrics for line layout (from the baked font if there is one):
+	for (uint32_t s = 0; s < StyleCount; ++s) {
+		Face &face = faces[s];
+		if (face.baked.glyphs.empty()) {
+			ensure_freetype(Style(s));
+			FT_Size_Metrics const &metrics = face.ft_face->size->metrics;
+			text_layouts[s].set_metrics(metrics.ascender / 64.0f, metrics.descender / 64.0f, metrics.height / 64.0f);
+		} else {
+			BakedFont::Header const &header = face.baked.header;
+			text_layouts[s].set_metrics(header.ascender / 64.0f, header.descender / 64.0f, header.line_height / 64.0f);
+		}
+	}
+
+	//upload now, so the first frame doesn't have to:
+	atlas.get_texture();
+}
+
+FontManager::~FontManager() {
+	for (Face &face : faces) {
+		if (face.hb_font) hb_font_destroy(face.hb_font);
+		if (face.ft_face) FT_Done_Face(face.ft_face);
+	}
+	if (ft_library) FT_Done_FreeType(ft_library);
+}
+
+void FontManager::ensure_freetype(Style style) const {
+	Face &face = faces[style];
+	if (face.hb_font) return;
+
+	// From Harfbuzz tutorial
+	if (!ft_library) {
+		if (FT_Init_FreeType(&ft_library) != 0) {
+			throw std::runtime_error("Failed to initialize FreeType.");
+		}
+	}
+	if (FT_New_Face(ft_library, face.ttf.c_str(), 0, &face.ft_face) != 0) {
+		throw std::runtime_error("Failed to load font '" + face.ttf + "'.");
+	}
+	// Help from Sarah Pethani debugging my font size (originally I didn't multiply by 64)
+	FT_Set_Char_Size(face.ft_face, GlyphSize * 64, GlyphSize * 64, 0, 0);
+	face.hb_font = hb_ft_font_create(face.ft_face, NULL);
+}
+
+ShapeCache::Run const &FontManager::shape(StringPool::Handle text, Style style) const {
+	// Shaping only happens when text hasn't been seen recently (and only needs HarfBuzz if the baked tables can't do it):
+	if (ShapeCache::Run const *cached = shape_cache.find(text, style, GlyphSize)) return *cached;
+
+	// (shape before inserting, so a failure -- e.g., no FreeType -- doesn't leave an empty run cached)
+	ShapeCache::Run run;
+	shape_uncached(string_pool[text], style, &run);
+
+	ShapeCache::Run &shaped = shape_cache.insert(text, style, GlyphSize);
+	shaped = std::move(run);
+	return shaped;
+}
+
+void FontManager::shape_uncached(std::string_view text, Style style, ShapeCache::Run *run) const {
+	if (!faces[style].baked.shape(text, run)) {
+		ensure_freetype(style);
+		shape_cache.shape(text, faces[style].hb_font, run);
+	}
+}
+
+TextLayout::Result const &FontManager::layout(StringPool::Handle text, Style style, float max_width, TextLayout::Align align) const {
+	// Layout only happens when (text, width) hasn't been seen recently:
+	return text_layouts[style].get(text, shape(text, style), style, GlyphSize, max_width, align);
+}
+
+ShapeCache::Run const &FontManager::shape_rich(StringPool::Handle markup, Style base) const {
+	std::string_view text = string_pool[markup];
+	if (RichText::is_plain(text)) return shape(markup, base);
+
+	uint32_t font_id = RichFontId + base;
+	if (ShapeCache::Run const *cached = shape_cache.find(markup, font_id, GlyphSize)) return *cached;
+
+	// Shape each span on its own (these go through the cache too), then stitch the results together:
+	// (n.b. this means no kerning across style changes)
+	std::vector< RichText::Span > spans;
+	RichText::parse(text, &spans);
+
+	ShapeCache::Run combined;
+	for (RichText::Span const &span : spans) {
+		StringPool::Handle span_text = string_pool.intern(text.substr(span.begin, span.end - span.begin));
+		ShapeCache::Run const &run = shape(span_text, span.bold ? bold(base) : base);
+		for (ShapeCache::Glyph glyph : run) {
+			glyph.cluster += span.begin;
+			glyph.bold = span.bold;
+			glyph.has_color = span.has_color;
+			glyph.color = span.color;
+			combined.emplace_back(glyph);
+		}
+	}
+
+	ShapeCache::Run &shaped = shape_cache.insert(markup, font_id, GlyphSize);
+	shaped = std::move(combined);
+	return shaped;
+}
+
+TextLayout::Result const &FontManager::layout_rich(StringPool::Handle markup, Style base, float max_width, TextLayout::Align align) const {
+	return text_layouts[base].get(markup, shape_rich(markup, base), RichFontId + base, GlyphSize, max_width, align);
+}
+
+TextLayout::Result const &FontManager::layout_transient(std::string_view text, Style style, float max_width, TextLayout::Align align) const {
+	shape_uncached(text, style, &transient_run);
+	text_layouts[style].lay_out(text, transient_run, max_width, align, &transient_layout);
+	return transient_layout;
+}
+
+GlyphAtlas::Glyph const *FontManager::glyph(Style style, uint32_t index) const {
+	uint32_t key = atlas_key(style, index);
+	if (GlyphAtlas::Glyph const *glyph = atlas.find(key)) return glyph;
+
+	// Not baked (or evicted); rasterize with FreeType:
+	ensure_freetype(style);
+	FT_Face ft_face = faces[style].ft_face;
+
+	// FT code based on https://freetype.org/freetype2/docs/tutorial/step1.html
+	FT_Load_Glyph(ft_face, index, FT_LOAD_DEFAULT);
+	FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+
+	FT_GlyphSlot slot = ft_face->glyph;
+	glm::ivec2 advance = glm::ivec2(slot->advance.x, slot->advance.y);
+
+	// Blank glyphs (e.g., spaces) just need their metrics:
+	if (slot->bitmap.width == 0 || slot->bitmap.rows == 0) {
+		return atlas.insert(key, glm::uvec2(0), nullptr, 0, glm::ivec2(slot->bitmap_left, slot->bitmap_top), advance);
+	}
+
+	// Store a distance field (padded by GlyphSpread on all sides) instead of coverage, so the glyph can be drawn at any size:
+	glm::uvec2 sdf_size;
+	std::vector< uint8_t > sdf = make_sdf(glm::uvec2(slot->bitmap.width, slot->bitmap.rows), slot->bitmap.buffer, slot->bitmap.pitch, GlyphSpread, &sdf_size);
+	return atlas.insert(key,
+		sdf_size, sdf.data(), int32_t(sdf_size.x),
+		glm::ivec2(slot->bitmap_left - int32_t(GlyphSpread), slot->bitmap_top + int32_t(GlyphSpread)),
+		advance
+	);
+}
+
+void FontManager::reset_atlas() const {
+	atlas.clear();
+	for (uint32_t s = 0; s < StyleCount; ++s) {
+		Face const &face = faces[s];
+		if (face.baked.glyphs.empty()) continue;
+		if (!face.baked.seed(&atlas, atlas_key(Style(s), 0))) {
+			std::cerr << "WARNING: no room in glyph atlas for baked " << StyleFiles[s] << " glyphs; they will be rasterized as needed." << std::endl;
+		}
+	}
+}
+
+GLuint FontManager::texture() const {
+	return atlas.get_texture();
+}
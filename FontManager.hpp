@@ -0,0 +1,130 @@
+#pragma once
+
+/*
+ * The FontManager owns everything needed to turn strings into glyph quads
+ *  for each of the bundled PT Serif styles, for the whole process:
+ *   - a baked font (see BakedFont.hpp) per style, if one was built
+ *   - FreeType faces + HarfBuzz fonts per style, created only if some text
+ *     needs a glyph or shaping the baked tables don't have
+ *   - one glyph atlas shared by all styles
+ *   - caches for shaping (ShapeCache.hpp) and line layout (TextLayout.hpp)
+ *
+ * Because glyphs are stored as signed distance fields, one shaping and
+ *  rasterization size (GlyphSize) serves text drawn at every size; callers
+ *  scale the results by (draw size / GlyphSize).
+ *
+ * Modes share the manager (and so reuse already-rasterized glyphs and
+ *  shaped strings) instead of each setting up their own fonts. Text is passed
+ *  as string_pool handles (see StringPool.hpp), which are what the caches key on.
+ *
+ * Load<> hands out a const pointer; everything the manager changes after
+ *  loading is a cache, so those members are declared 'mutable'.
+ *
+ */
+
+#include "BakedFont.hpp"
+#include "GlyphAtlas.hpp"
+#include "ShapeCache.hpp"
+#include "TextLayout.hpp"
+#include "RichText.hpp"
+#include "StringPool.hpp"
+#include "Load.hpp"
+
+#include <hb.h>
+#include <hb-ft.h>
+#include <freetype/freetype.h>
+
+#include <array>
+#include <string>
+#include <string_view>
+
+struct FontManager {
+	FontManager();
+	~FontManager();
+
+	FontManager(FontManager const &) = delete;
+	FontManager &operator=(FontManager const &) = delete;
+
+	enum Style : uint32_t {
+		Regular,
+		Bold,
+		Italic,
+		BoldItalic,
+		StyleCount //<-- just used to track # of styles
+	};
+
+	static constexpr uint32_t GlyphSize = 48; //size glyphs are shaped and rasterized at
+	static constexpr uint32_t GlyphSpread = 6; //distance field range (in pixels at GlyphSize)
+
+	//shaped glyphs for pooled string 'text' (see StringPool.hpp) in 'style' (shaping it if it isn't cached):
+	// (returned reference is valid until the next call to shape())
+	ShapeCache::Run const &shape(StringPool::Handle text, Style style) const;
+
+	//'text' in 'style' laid out in lines no wider than 'max_width' (in pixels at GlyphSize; <= 0 for no limit):
+	// (returned reference is valid until the next call to layout())
+	TextLayout::Result const &layout(StringPool::Handle text, Style style, float max_width, TextLayout::Align align = TextLayout::AlignLeft) const;
+
+	//rich text (see RichText.hpp): 'markup' with bold spans in bold(base), shaped as one run
+	// whose clusters are byte offsets into 'markup'; each glyph carries its span's bold flag and color,
+	// so the markup is only parsed when the run is shaped:
+	// (returned reference is valid until the next call to shape() or shape_rich())
+	ShapeCache::Run const &shape_rich(StringPool::Handle markup, Style base) const;
+	// ...and laid out like layout():
+	TextLayout::Result const &layout_rich(StringPool::Handle markup, Style base, float max_width, TextLayout::Align align = TextLayout::AlignLeft) const;
+
+	//plain text that changes too often to be worth interning or caching (e.g., counters), laid out like layout():
+	// (markup is not interpreted; returned reference is valid until the next call to layout_transient())
+	TextLayout::Result const &layout_transient(std::string_view text, Style style, float max_width, TextLayout::Align align = TextLayout::AlignLeft) const;
+
+	//bold version of a style:
+	static Style bold(Style style) {
+		return (style == Italic || style == BoldItalic ? BoldItalic : Bold);
+	}
+
+	//atlas entry for glyph 'index' of 'style', rasterizing it if needed:
+	// returns nullptr if the atlas is full -- call reset_atlas() and try again.
+	GlyphAtlas::Glyph const *glyph(Style style, uint32_t index) const;
+
+	//evict all glyphs rasterized at runtime (baked glyphs are put back):
+	void reset_atlas() const;
+
+	//upload any atlas changes and return its texture:
+	GLuint texture() const;
+
+	//caches (public so callers can read their counters):
+	mutable ShapeCache shape_cache;
+	mutable std::array< TextLayout, StyleCount > text_layouts; //(one per style, since vertical metrics differ)
+	mutable GlyphAtlas atlas;
+
+	//scratch space for layout_transient():
+	mutable ShapeCache::Run transient_run;
+	mutable TextLayout::Result transient_layout;
+
+	//--- internals ---
+
+	struct Face {
+		std::string ttf; //font file (full path)
+		BakedFont baked; //empty if there was no (usable) baked font file
+		FT_Face ft_face = nullptr;
+		hb_font_t *hb_font = nullptr;
+	};
+	mutable std::array< Face, StyleCount > faces;
+	mutable FT_Library ft_library = nullptr;
+
+	//shape with the baked tables if they cover 'text', HarfBuzz otherwise (without caching):
+	void shape_uncached(std::string_view text, Style style, ShapeCache::Run *run) const;
+
+	//create the FreeType face + HarfBuzz font for 'style', if not done already:
+	void ensure_freetype(Style style) const;
+
+	//font_id used in the caches for rich text with base style 's' is RichFontId + s:
+	static constexpr uint32_t RichFontId = 0x100;
+
+	//atlas keys are (style << KeyStyleShift) + glyph index:
+	static constexpr uint32_t KeyStyleShift = 24;
+	static uint32_t atlas_key(Style style, uint32_t index) {
+		return (uint32_t(style) << KeyStyleShift) + index;
+	}
+};
+
+extern Load< FontManager > fonts;
@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+ * GameState is everything about a playthrough that decides what choices do
+ *  (see Story.hpp): the items + flags held, as one 64-bit bitset, and where
+ *  the player is in the story graph.
+ *
+ * It is 16 bytes of plain integers -- trivially copyable, so states can be
+ *  copied, compared, hashed, and snapshotted as raw memory.
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+struct GameState {
+	uint64_t bits = 0; //items + flags; bit i is Story::bits[i]
+	uint32_t node = 0; //current story node
+	uint32_t location = 0; //(== the node's location; kept here so it doesn't need a lookup)
+
+	bool has(uint32_t bit) const {
+		return (bits >> bit) & 1;
+	}
+
+	bool operator==(GameState const &other) const {
+		return bits == other.bits && node == other.node && location == other.location;
+	}
+	bool operator!=(GameState const &other) const {
+		return !(*this == other);
+	}
+
+	//(location is determined by node, so it isn't mixed in)
+	size_t hash() const {
+		//splitmix64-style finalizer over the two words:
+		uint64_t h = bits ^ (uint64_t(node) * 0x9e3779b97f4a7c15ull);
+		h ^= h >> 30;
+		h *= 0xbf58476d1ce4e5b9ull;
+		h ^= h >> 27;
+		h *= 0x94d049bb133111ebull;
+		h ^= h >> 31;
+		return size_t(h);
+	}
+};
+
+static_assert(std::is_trivially_copyable< GameState >::value, "GameState can be copied as raw memory");
+static_assert(sizeof(GameState) == 16, "GameState is packed");
+
+namespace std {
+	template< >
+	struct hash< GameState > {
+		size_t operator()(GameState const &state) const {
+			return state.hash();
+		}
+	};
+}
@@ -0,0 +1,199 @@
+#include "GlyphAtlas.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+GlyphAtlas::GlyphAtlas(glm::uvec2 size_, glm::uvec2 max_size_) : size(size_), max_size(max_size_) {
+	assert(size.x > 0 && size.y > 0);
+	assert(size.x <= max_size.x && size.y <= max_size.y);
+	pixels.assign(size.x * size.y, 0);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+	if (texture != 0) {
+		glDeleteTextures(1, &texture);
+		texture = 0;
+	}
+}
+
+GlyphAtlas::Glyph const *GlyphAtlas::find(uint32_t key) const {
+	auto f = glyphs.find(key);
+	if (f == glyphs.end()) return nullptr;
+	return &f->second;
+}
+
+GlyphAtlas::Glyph const *GlyphAtlas::insert(uint32_t key, glm::uvec2 bitmap_size, uint8_t const *bitmap, int32_t pitch, glm::ivec2 bearing, glm::ivec2 advance) {
+	assert(glyphs.count(key) == 0 && "shouldn't insert the same key twice");
+
+	glm::uvec2 origin;
+	if (!allocate(bitmap_size.x + Padding, bitmap_size.y + Padding, &origin)) {
+		return nullptr;
+	}
+
+	//copy bitmap rows into the atlas:
+	for (uint32_t row = 0; row < bitmap_size.y; ++row) {
+		uint8_t const *src = bitmap + int32_t(row) * pitch;
+		uint8_t *dst = &pixels[(origin.y + row) * size.x + origin.x];
+		std::memcpy(dst, src, bitmap_size.x);
+	}
+
+	//note changed rows for upload:
+	if (dirty_begin == dirty_end) {
+		dirty_begin = origin.y;
+		dirty_end = origin.y + bitmap_size.y;
+	} else {
+		dirty_begin = std::min(dirty_begin, origin.y);
+		dirty_end = std::max(dirty_end, origin.y + bitmap_size.y);
+	}
+
+	Glyph &glyph = glyphs[key];
+	glyph.origin = origin;
+	glyph.size = bitmap_size;
+	glyph.uv_min = glm::vec2(origin) / glm::vec2(size);
+	glyph.uv_max = glm::vec2(origin + bitmap_size) / glm::vec2(size);
+	glyph.bearing = bearing;
+	glyph.advance = advance;
+	return &glyph;
+}
+
+void GlyphAtlas::clear() {
+	glyphs.clear();
+	shelves.clear();
+	std::fill(pixels.begin(), pixels.end(), uint8_t(0));
+	dirty_begin = 0;
+	dirty_end = size.y;
+}
+
+bool GlyphAtlas::insert_block(glm::uvec2 block_size, uint8_t const *block, glm::uvec2 *origin_) {
+	assert(origin_);
+	auto &origin = *origin_;
+
+	if (!allocate(block_size.x + Padding, block_size.y + Padding, &origin)) {
+		return false;
+	}
+
+	for (uint32_t row = 0; row < block_size.y; ++row) {
+		std::memcpy(&pixels[(origin.y + row) * size.x + origin.x], block + row * block_size.x, block_size.x);
+	}
+
+	//note changed rows for upload:
+	if (dirty_begin == dirty_end) {
+		dirty_begin = origin.y;
+		dirty_end = origin.y + block_size.y;
+	} else {
+		dirty_begin = std::min(dirty_begin, origin.y);
+		dirty_end = std::max(dirty_end, origin.y + block_size.y);
+	}
+
+	return true;
+}
+
+GlyphAtlas::Glyph const *GlyphAtlas::insert_placed(uint32_t key, glm::uvec2 origin, glm::uvec2 bitmap_size, glm::ivec2 bearing, glm::ivec2 advance) {
+	assert(glyphs.count(key) == 0 && "shouldn't insert the same key twice");
+	assert(origin.x + bitmap_size.x <= size.x && origin.y + bitmap_size.y <= size.y);
+
+	Glyph &glyph = glyphs[key];
+	glyph.origin = origin;
+	glyph.size = bitmap_size;
+	glyph.uv_min = glm::vec2(origin) / glm::vec2(size);
+	glyph.uv_max = glm::vec2(origin + bitmap_size) / glm::vec2(size);
+	glyph.bearing = bearing;
+	glyph.advance = advance;
+	return &glyph;
+}
+
+bool GlyphAtlas::allocate(uint32_t w, uint32_t h, glm::uvec2 *origin_) {
+	assert(origin_);
+	auto &origin = *origin_;
+
+	if (w > size.x) return false; //never going to fit
+
+	while (true) {
+		//look for the existing shelf that wastes the least height:
+		Shelf *best = nullptr;
+		for (auto &shelf : shelves) {
+			if (shelf.height < h) continue;
+			if (shelf.x + w > size.x) continue;
+			if (best == nullptr || shelf.height < best->height) best = &shelf;
+		}
+		//...but don't put short glyphs on very tall shelves if a new shelf would do:
+		uint32_t top = (shelves.empty() ? 0 : shelves.back().y + shelves.back().height);
+		if (best && best->height > h + h / 2 && top + h <= size.y) best = nullptr;
+
+		if (best) {
+			origin = glm::uvec2(best->x, best->y);
+			best->x += w;
+			return true;
+		}
+
+		//open a new shelf:
+		if (top + h <= size.y) {
+			shelves.emplace_back();
+			Shelf &shelf = shelves.back();
+			shelf.y = top;
+			shelf.height = h;
+			shelf.x = w;
+			origin = glm::uvec2(0, top);
+			return true;
+		}
+
+		//out of room; try to make more:
+		if (!grow()) return false;
+	}
+}
+
+bool GlyphAtlas::grow() {
+	if (size.y >= max_size.y) return false;
+
+	size.y = std::min(size.y * 2, max_size.y);
+
+	//rows are stored top-to-bottom, so the existing pixels stay put:
+	pixels.resize(size.x * size.y, 0);
+	dirty_begin = 0;
+	dirty_end = size.y;
+
+	//texture coordinates are relative to the atlas size, so they all change:
+	for (auto &kv : glyphs) {
+		Glyph &glyph = kv.second;
+		glyph.uv_min = glm::vec2(glyph.origin) / glm::vec2(size);
+		glyph.uv_max = glm::vec2(glyph.origin + glyph.size) / glm::vec2(size);
+	}
+
+	return true;
+}
+
+GLuint GlyphAtlas::get_texture() {
+	if (texture == 0) {
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	if (texture_size != size) {
+		//(re-)allocate texture storage and upload everything:
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, size.x, size.y, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+		glBindTexture(GL_TEXTURE_2D, 0);
+		texture_size = size;
+		dirty_begin = dirty_end = 0;
+	} else if (dirty_begin < dirty_end) {
+		//upload just the rows that changed:
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirty_begin, size.x, dirty_end - dirty_begin, GL_RED, GL_UNSIGNED_BYTE, pixels.data() + dirty_begin * size.x);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		dirty_begin = dirty_end = 0;
+	}
+
+	GL_ERRORS();
+
+	return texture;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+/*
+ * A GlyphAtlas packs many small single-channel bitmaps (e.g., rasterized
+ *  glyphs) into one GL_RED texture, so text can be drawn without switching
+ *  textures between characters.
+ *
+ * Bitmaps are placed with a simple shelf packer: rows ("shelves") are opened
+ *  top-to-bottom, and each bitmap goes on the shelf that wastes the least
+ *  height. When no shelf has room, the atlas grows (doubling its height) up
+ *  to max_size; after that insert() fails and the caller is expected to
+ *  clear() the atlas and re-insert whatever it is currently drawing.
+ *
+ * A CPU-side copy of the pixels is kept so that growth doesn't need to read
+ *  back from the GPU; changes are uploaded lazily by get_texture().
+ *
+ * Each entry also remembers the metrics needed to place its bitmap, so that
+ *  drawing an already-inserted glyph needs no calls into FreeType at all.
+ *
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+struct GlyphAtlas {
+	//atlas starts at 'size' and may grow (in height) up to 'max_size':
+	GlyphAtlas(glm::uvec2 size = glm::uvec2(512, 256), glm::uvec2 max_size = glm::uvec2(512, 2048));
+	~GlyphAtlas();
+
+	//since atlas owns a GL texture, copying is not advised:
+	GlyphAtlas(GlyphAtlas const &) = delete;
+	GlyphAtlas &operator=(GlyphAtlas const &) = delete;
+
+	struct Glyph {
+		glm::uvec2 origin = glm::uvec2(0); //upper-left pixel of bitmap in atlas
+		glm::uvec2 size = glm::uvec2(0); //size of bitmap in pixels
+		//texture coordinates of the upper-left and lower-right corners of the bitmap:
+		// (n.b. row 0 of the bitmap is the top row, so uv_min.y is the *top* of the glyph)
+		glm::vec2 uv_min = glm::vec2(0.0f);
+		glm::vec2 uv_max = glm::vec2(0.0f);
+		//placement metrics (as in FT_GlyphSlot):
+		glm::ivec2 bearing = glm::ivec2(0); //(bitmap_left, bitmap_top): offset from pen position to upper-left of bitmap, in pixels
+		glm::ivec2 advance = glm::ivec2(0); //pen movement after this glyph, in 26.6 fixed point
+	};
+
+	//look up a previously-inserted bitmap (nullptr if not present):
+	Glyph const *find(uint32_t key) const;
+
+	//copy a bitmap (and its placement metrics) into the atlas:
+	// 'pitch' is the (signed) distance in bytes between rows of 'pixels', as in FT_Bitmap
+	// returns nullptr if the atlas is full (at max_size) -- call clear() and try again.
+	Glyph const *insert(uint32_t key, glm::uvec2 size, uint8_t const *pixels, int32_t pitch,
+		glm::ivec2 bearing = glm::ivec2(0), glm::ivec2 advance = glm::ivec2(0));
+
+	//evict everything:
+	void clear();
+
+	//copy a pre-packed block of bitmaps (e.g., from a baked font file) into the atlas without adding any entries:
+	// returns false if the atlas is full; otherwise sets 'origin' to where the block's upper-left pixel went.
+	// (use insert_placed() to add entries for the bitmaps in the block)
+	bool insert_block(glm::uvec2 size, uint8_t const *pixels, glm::uvec2 *origin);
+
+	//record metrics for a bitmap that is already in the atlas pixels (e.g., placed by insert_block()):
+	Glyph const *insert_placed(uint32_t key, glm::uvec2 origin, glm::uvec2 size,
+		glm::ivec2 bearing = glm::ivec2(0), glm::ivec2 advance = glm::ivec2(0));
+
+	//upload any pending changes and return the texture name:
+	// (only call with a GL context current)
+	GLuint get_texture();
+
+	//--- internals ---
+
+	glm::uvec2 size;
+	glm::uvec2 max_size;
+	std::vector< uint8_t > pixels; //size.x * size.y, row 0 at top
+
+	struct Shelf {
+		uint32_t y = 0; //top of shelf
+		uint32_t height = 0; //height of shelf
+		uint32_t x = 0; //first free column on shelf
+	};
+	std::vector< Shelf > shelves;
+
+	std::unordered_map< uint32_t, Glyph > glyphs;
+
+	//gap left around each bitmap so linear filtering doesn't bleed between glyphs:
+	static constexpr uint32_t Padding = 1;
+
+	//GL texture, and what part of it needs to be re-uploaded:
+	GLuint texture = 0;
+	glm::uvec2 texture_size = glm::uvec2(0);
+	uint32_t dirty_begin = 0, dirty_end = 0; //rows [begin,end) have changed since last upload
+
+	//find a spot for a w x h bitmap (including padding); returns false if there is no room:
+	bool allocate(uint32_t w, uint32_t h, glm::uvec2 *origin);
+	//double the height of the atlas (returns false if already at max_size):
+	bool grow();
+};
@@ -0,0 +1,182 @@
+#include "InputLog.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+//append a value's bytes to a record buffer:
+template< typename T >
+static void put(std::vector< char > &to, T const &value) {
+	char const *bytes = reinterpret_cast< char const * >(&value);
+	to.insert(to.end(), bytes, bytes + sizeof(T));
+}
+
+InputRecorder::InputRecorder(std::string const &filename_) : filename(filename_) {
+	out.open(filename, std::ios::binary);
+	if (!out) throw std::runtime_error("Failed to open '" + filename + "' to record input.");
+	out.write("inp0", 4);
+	out.write(reinterpret_cast< char const * >(&InputLog::Version), sizeof(InputLog::Version));
+	buffer.reserve(4096);
+}
+
+InputRecorder::~InputRecorder() {
+	out.write(buffer.data(), buffer.size());
+	out.close();
+}
+
+void InputRecorder::event(SDL_Event const &evt) {
+	if (evt.type == SDL_KEYDOWN || evt.type == SDL_KEYUP) {
+		put(buffer, InputLog::Key);
+		put(buffer, uint8_t(evt.type == SDL_KEYDOWN));
+		put(buffer, uint8_t(evt.key.repeat));
+		put(buffer, uint16_t(evt.key.keysym.mod));
+		put(buffer, int32_t(evt.key.keysym.sym));
+		put(buffer, int32_t(evt.key.keysym.scancode));
+	} else if (evt.type == SDL_MOUSEMOTION) {
+		put(buffer, InputLog::MouseMotion);
+		put(buffer, uint32_t(evt.motion.state));
+		put(buffer, int32_t(evt.motion.x));
+		put(buffer, int32_t(evt.motion.y));
+		put(buffer, int32_t(evt.motion.xrel));
+		put(buffer, int32_t(evt.motion.yrel));
+	} else if (evt.type == SDL_MOUSEBUTTONDOWN || evt.type == SDL_MOUSEBUTTONUP) {
+		put(buffer, InputLog::MouseButton);
+		put(buffer, uint8_t(evt.type == SDL_MOUSEBUTTONDOWN));
+		put(buffer, uint8_t(evt.button.button));
+		put(buffer, uint8_t(evt.button.clicks));
+		put(buffer, int32_t(evt.button.x));
+		put(buffer, int32_t(evt.button.y));
+	} else if (evt.type == SDL_MOUSEWHEEL) {
+		put(buffer, InputLog::MouseWheel);
+		put(buffer, int32_t(evt.wheel.x));
+		put(buffer, int32_t(evt.wheel.y));
+	} else if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+		put(buffer, InputLog::WindowSize);
+		put(buffer, int32_t(evt.window.data1));
+		put(buffer, int32_t(evt.window.data2));
+	} else if (evt.type == SDL_QUIT) {
+		put(buffer, InputLog::Quit);
+	} else {
+		return;
+	}
+	buffer_has_events = true;
+}
+
+void InputRecorder::frame(float elapsed) {
+	put(buffer, InputLog::Frame);
+	put(buffer, elapsed);
+	frames += 1;
+
+	//write out frames with input right away (so a log survives a crash right after the input that caused it);
+	// idle frames are batched:
+	if (buffer_has_events || buffer.size() >= 4096) {
+		out.write(buffer.data(), buffer.size());
+		out.flush();
+		buffer.clear();
+		buffer_has_events = false;
+	}
+}
+
+InputReplay::InputReplay(std::string const &filename_) : filename(filename_) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in) throw std::runtime_error("Failed to open input log '" + filename + "'.");
+	data.assign(std::istreambuf_iterator< char >(in), std::istreambuf_iterator< char >());
+
+	uint32_t version = 0;
+	if (data.size() < 8 || std::memcmp(data.data(), "inp0", 4) != 0) {
+		throw std::runtime_error("'" + filename + "' is not an input log.");
+	}
+	std::memcpy(&version, data.data() + 4, sizeof(version));
+	if (version != InputLog::Version) {
+		throw std::runtime_error("Input log '" + filename + "' has version " + std::to_string(version) + ", expected " + std::to_string(InputLog::Version) + ".");
+	}
+	at = 8;
+}
+
+bool InputReplay::next_frame(std::vector< SDL_Event > *events_, float *elapsed) {
+	assert(events_);
+	assert(elapsed);
+	auto &events = *events_;
+	events.clear();
+
+	//read a value, or note that the log was cut off (e.g., by a crash while recording):
+	bool truncated = false;
+	auto get = [&](auto *value) {
+		if (at + sizeof(*value) > data.size()) {
+			truncated = true;
+			std::memset(value, 0, sizeof(*value));
+			return;
+		}
+		std::memcpy(value, data.data() + at, sizeof(*value));
+		at += sizeof(*value);
+	};
+
+	while (at < data.size()) {
+		uint8_t tag = 0;
+		get(&tag);
+
+		SDL_Event evt;
+		std::memset(&evt, 0, sizeof(evt));
+		if (tag == InputLog::Frame) {
+			get(elapsed);
+			if (truncated) break;
+			frames += 1;
+			return true;
+		} else if (tag == InputLog::Key) {
+			uint8_t down = 0, repeat = 0;
+			uint16_t mod = 0;
+			int32_t sym = 0, scancode = 0;
+			get(&down); get(&repeat); get(&mod); get(&sym); get(&scancode);
+			evt.type = (down ? SDL_KEYDOWN : SDL_KEYUP);
+			evt.key.state = (down ? SDL_PRESSED : SDL_RELEASED);
+			evt.key.repeat = repeat;
+			evt.key.keysym.mod = mod;
+			evt.key.keysym.sym = sym;
+			evt.key.keysym.scancode = SDL_Scancode(scancode);
+		} else if (tag == InputLog::MouseMotion) {
+			uint32_t state = 0;
+			int32_t x = 0, y = 0, xrel = 0, yrel = 0;
+			get(&state); get(&x); get(&y); get(&xrel); get(&yrel);
+			evt.type = SDL_MOUSEMOTION;
+			evt.motion.state = state;
+			evt.motion.x = x;
+			evt.motion.y = y;
+			evt.motion.xrel = xrel;
+			evt.motion.yrel = yrel;
+		} else if (tag == InputLog::MouseButton) {
+			uint8_t down = 0, button = 0, clicks = 0;
+			int32_t x = 0, y = 0;
+			get(&down); get(&button); get(&clicks); get(&x); get(&y);
+			evt.type = (down ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP);
+			evt.button.state = (down ? SDL_PRESSED : SDL_RELEASED);
+			evt.button.button = button;
+			evt.button.clicks = clicks;
+			evt.button.x = x;
+			evt.button.y = y;
+		} else if (tag == InputLog::MouseWheel) {
+			int32_t x = 0, y = 0;
+			get(&x); get(&y);
+			evt.type = SDL_MOUSEWHEEL;
+			evt.wheel.x = x;
+			evt.wheel.y = y;
+		} else if (tag == InputLog::WindowSize) {
+			int32_t w = 0, h = 0;
+			get(&w); get(&h);
+			evt.type = SDL_WINDOWEVENT;
+			evt.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+			evt.window.data1 = w;
+			evt.window.data2 = h;
+		} else if (tag == InputLog::Quit) {
+			evt.type = SDL_QUIT;
+		} else {
+			throw std::runtime_error("Input log '" + filename + "' has unknown record tag " + std::to_string(int(tag)) + " at byte " + std::to_string(at - 1) + ".");
+		}
+		if (truncated) break;
+		events.emplace_back(evt);
+	}
+
+	//(events after the last complete frame are dropped; they never reached an update)
+	events.clear();
+	at = data.size();
+	return false;
+}
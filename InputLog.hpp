@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+ * Input logs record what the main loop feeds the current Mode -- the SDL
+ *  events it handles and the 'elapsed' passed to each update -- so a session
+ *  can be replayed exactly (see main.cpp's --record and --replay options).
+ *
+ * The file is a small header followed by tagged records in native byte order:
+ *
+ *    'inp0' magic, uint32_t version
+ *    Key:         uint8_t tag, down, repeat; uint16_t mod; int32_t sym, scancode
+ *    MouseMotion: uint8_t tag; uint32_t state; int32_t x, y, xrel, yrel
+ *    MouseButton: uint8_t tag, down, button, clicks; int32_t x, y
+ *    MouseWheel:  uint8_t tag; int32_t x, y
+ *    WindowSize:  uint8_t tag; int32_t w, h
+ *    Quit:        uint8_t tag
+ *    Frame:       uint8_t tag; float elapsed  (ends a frame's events)
+ *
+ * (Records are packed with no alignment, so an idle frame costs five bytes.)
+ * Other event types (text input, controllers, ...) aren't used by the game
+ *  and aren't recorded.
+ *
+ */
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace InputLog {
+	static constexpr uint32_t Version = 1;
+
+	enum Tag : uint8_t {
+		Frame = 0,
+		Key = 1,
+		MouseMotion = 2,
+		MouseButton = 3,
+		MouseWheel = 4,
+		WindowSize = 5,
+		Quit = 6,
+	};
+}
+
+struct InputRecorder {
+	//start recording to 'filename'; throws on error:
+	InputRecorder(std::string const &filename);
+	~InputRecorder(); //(writes anything still buffered)
+
+	InputRecorder(InputRecorder const &) = delete;
+	InputRecorder &operator=(InputRecorder const &) = delete;
+
+	//record an event handed to the mode (ignores event types the log doesn't cover):
+	void event(SDL_Event const &evt);
+	//end the frame's events and record the 'elapsed' passed to update:
+	void frame(float elapsed);
+
+	uint64_t frames = 0;
+
+	//--- internals ---
+	std::string filename;
+	std::ofstream out;
+	std::vector< char > buffer; //records not yet written to 'out'
+	bool buffer_has_events = false;
+};
+
+struct InputReplay {
+	//read the whole log in 'filename'; throws on error:
+	InputReplay(std::string const &filename);
+
+	//events and elapsed time of the next recorded frame; returns false once the log is used up:
+	// (events are rebuilt with the fields the log stores; the rest are zero)
+	bool next_frame(std::vector< SDL_Event > *events, float *elapsed);
+
+	uint64_t frames = 0; //frames returned so far
+
+	//--- internals ---
+	std::string filename;
+	std::vector< char > data;
+	size_t at = 0;
+};
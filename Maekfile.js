@@ -43,7 +43,7 @@ if (maek.OS === "windows") {
 		`/wd4611`  //interaction between setjmp and C++ object destruction
 	);
 	maek.options.LINKLibs.push(
-		`/LIBPATH:${NEST_LIBS}/SDL2/lib`, `SDL2main.lib`, `SDL2.lib`, `OpenGL32.lib`, `Shell32.lib`,
+		`/LIBPATH:${NEST_LIBS}/SDL2/lib`, `SDL2main.lib`, `SDL2.lib`, `OpenGL32.lib`, `Shell32.lib`, `Psapi.lib`,
 		`/LIBPATH:${NEST_LIBS}/libpng/lib`, `libpng.lib`,
 		`/LIBPATH:${NEST_LIBS}/zlib/lib`, `zlib.lib`,
 		`/LIBPATH:${NEST_LIBS}/opusfile/lib`, `opusfile.lib`,
@@ -140,6 +140,23 @@ const game_names = [
 	maek.CPP('main.cpp'),
 	maek.CPP('LitColorTextureProgram.cpp'),
 	maek.CPP('ColorTextureProgram.cpp'),
+	maek.CPP('SdfTextProgram.cpp'),
+	maek.CPP('GlyphAtlas.cpp'),
+	maek.CPP('make_sdf.cpp'),
+	maek.CPP('TextBatch.cpp'),
+	maek.CPP('ShapeCache.cpp'),
+	maek.CPP('TextLayout.cpp'),
+	maek.CPP('RichText.cpp'),
+	maek.CPP('BakedFont.cpp'),
+	maek.CPP('FontManager.cpp'),
+	maek.CPP('Story.cpp'),
+	maek.CPP('Playthrough.cpp'),
+	maek.CPP('MappedFile.cpp'),
+	maek.CPP('StringPool.cpp'),
+	maek.CPP('resource_usage.cpp'),
+	maek.CPP('InputLog.cpp'),
+	maek.CPP('StorySource.cpp'),
+	maek.CPP('FileWatcher.cpp'),
 	maek.CPP('Sound.cpp'),
 	maek.CPP('load_wav.cpp'),
 	maek.CPP('load_opus.cpp')
@@ -152,6 +169,8 @@ const common_names = [
 	maek.CPP('DrawLines.cpp'),
 	maek.CPP('ColorProgram.cpp'),
 	maek.CPP('Scene.cpp'),
+	maek.CPP('world_matrices.cpp'),
+	maek.CPP('WorkerPool.cpp'),
 	maek.CPP('Mesh.cpp'),
 	maek.CPP('load_save_png.cpp'),
 	maek.CPP('gl_compile_program.cpp'),
@@ -176,6 +195,58 @@ const freetype_test_names = [
 	maek.CPP('freetype-test.cpp')
 ];
 
+const text_bench_names = [
+	maek.CPP('text-bench.cpp'),
+	maek.CPP('GlyphAtlas.cpp'),
+	maek.CPP('ShapeCache.cpp'),
+	maek.CPP('StringPool.cpp'),
+	maek.CPP('data_path.cpp'),
+	maek.CPP('GL.cpp')
+];
+
+const transform_bench_names = [
+	maek.CPP('transform-bench.cpp'),
+	maek.CPP('Scene.cpp'),
+	maek.CPP('world_matrices.cpp'),
+	maek.CPP('WorkerPool.cpp'),
+	maek.CPP('GL.cpp')
+];
+
+const bake_font_names = [
+	maek.CPP('bake-font.cpp'),
+	maek.CPP('BakedFont.cpp'),
+	maek.CPP('GlyphAtlas.cpp'),
+	maek.CPP('make_sdf.cpp'),
+	maek.CPP('GL.cpp')
+];
+
+const story_compile_names = [
+	maek.CPP('story-compile.cpp'),
+	maek.CPP('StorySource.cpp'),
+	maek.CPP('Story.cpp'),
+	maek.CPP('MappedFile.cpp')
+];
+
+const story_sim_names = [
+	maek.CPP('story-sim.cpp'),
+	maek.CPP('Playthrough.cpp'),
+	maek.CPP('Story.cpp'),
+	maek.CPP('MappedFile.cpp')
+];
+
+const story_fuzz_names = [
+	maek.CPP('story-fuzz.cpp'),
+	maek.CPP('Playthrough.cpp'),
+	maek.CPP('Story.cpp'),
+	maek.CPP('MappedFile.cpp')
+];
+
+const story_explore_names = [
+	maek.CPP('story-explore.cpp'),
+	maek.CPP('Story.cpp'),
+	maek.CPP('MappedFile.cpp')
+];
+
 //the '[exeFile =] LINK(objFiles, exeFileBase, [, options])' links an array of objects into an executable:
 // objFiles: array of objects to link
 // exeFileBase: name of executable file to produce
@@ -186,8 +257,39 @@ const show_scene_exe = maek.LINK([...show_scene_names, ...common_names], 'scenes
 
 const freetype_test_exe = maek.LINK([...freetype_test_names], 'freetype-test');
 
+const text_bench_exe = maek.LINK([...text_bench_names], 'text-bench');
+
+const transform_bench_exe = maek.LINK([...transform_bench_names], 'transform-bench');
+
+const bake_font_exe = maek.LINK([...bake_font_names], 'bake-font');
+
+const story_compile_exe = maek.LINK([...story_compile_names], 'story-compile');
+
+const story_sim_exe = maek.LINK([...story_sim_names], 'story-sim');
+
+const story_fuzz_exe = maek.LINK([...story_fuzz_names], 'story-fuzz');
+
+const story_explore_exe = maek.LINK([...story_explore_names], 'story-explore');
+
+//bake the game's fonts (glyph distance fields + shaping tables) so the game doesn't need FreeType at startup:
+const baked_fonts = [];
+for (const style of ['Regular', 'Bold', 'Italic', 'BoldItalic']) {
+	const ttf = `dist/PTSerif-${style}.ttf`;
+	const atlas = `dist/PTSerif-${style}.atlas`;
+	maek.RULE([atlas], [bake_font_exe, ttf], [
+		[bake_font_exe, ttf, atlas]
+	]);
+	baked_fonts.push(atlas);
+}
+
+//compile the story so the game can map it instead of parsing text at startup:
+const story_bin = 'dist/story.bin';
+maek.RULE([story_bin], [story_compile_exe, 'dist/story.txt'], [
+	[story_compile_exe, 'dist/story.txt', story_bin]
+]);
+
 //set the default target to the game (and copy the readme files):
-maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, freetype_test_exe, ...copies];
+maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, freetype_test_exe, text_bench_exe, transform_bench_exe, bake_font_exe, ...baked_fonts, story_compile_exe, story_bin, story_sim_exe, story_fuzz_exe, story_explore_exe, ...copies];
 
 //the '[targets =] RULE(targets, prerequisites[, recipe])' rule defines a Makefile-style task
 // targets: array of targets the task produces (can include both files and ':abstract targets')
@@ -195,7 +297,43 @@ maek.TARGETS = [game_exe, show_meshes_exe, show_scene_exe, freetype_test_exe, ..
 // recipe (optional): array of commands to run (where each command is an array [exe, arg1, arg0, ...])
 //returns targets: the targets the rule produces
 maek.RULE([':run'], [game_exe], [
-	[game_exe, '--some-command-line-option']
+	[game_exe]
+]);
+
+//leak check: run 20 thousand frames with synthetic input and report GL object counts + memory:
+maek.RULE([':soak'], [game_exe], [
+	[game_exe, '--soak', '20']
+]);
+
+//compare text drawing CPU cost with and without the shaping/glyph caches:
+maek.RULE([':text-bench'], [text_bench_exe], [
+	[text_bench_exe]
+]);
+
+//compare scene world-matrix updates done per transform with glm against the batched kernel (1k, 10k, 100k transforms), then the kernel on 1, 2, 4, ... threads:
+maek.RULE([':transform-bench'], [transform_bench_exe], [
+	[transform_bench_exe]
+]);
+
+//story logic without a window: random play (reports steps per second) and scripted playthroughs that must reach each ending:
+maek.RULE([':story-sim'], [story_sim_exe, story_bin], [
+	[story_sim_exe, story_bin, '--random', '10000000']
+]);
+
+maek.RULE([':story-check'], [story_sim_exe, story_bin], [
+	[story_sim_exe, story_bin, '--script', 'RRLRLLL', '--expect', 'ship'],
+	[story_sim_exe, story_bin, '--script', 'RRLRRLLRR', '--expect', 'raft_win'],
+	[story_sim_exe, story_bin, '--script', 'RL', '--expect', 'cell_over']
+]);
+
+//random + adversarial choice streams against the rules' invariants (dist/sets.scene has 12 cameras), with choice latency percentiles:
+maek.RULE([':story-fuzz'], [story_fuzz_exe, story_bin], [
+	[story_fuzz_exe, story_bin, '--steps', '1000000', '--cameras', '12']
+]);
+
+//every reachable story state: unreachable nodes, dead ends, shortest solutions, unused text and edges:
+maek.RULE([':story-explore'], [story_explore_exe, story_bin], [
+	[story_explore_exe, story_bin]
 ]);
 
 //Note that tasks that produce ':abstract targets' are never cached.
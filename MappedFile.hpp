@@ -0,0 +1,33 @@
+#pragma once
+
+/*
+ * MappedFile maps a whole file read-only into memory.
+ *
+ * Pages are loaded by the OS as they are touched and are shared with any
+ *  other process mapping the same file, so "loading" a large file costs
+ *  about as much as opening it.
+ *
+ * The mapping lives as long as the MappedFile; data is page-aligned.
+ *
+ */
+
+#include <cstddef>
+#include <string>
+
+struct MappedFile {
+	//map 'filename'; throws on error:
+	MappedFile(std::string const &filename);
+	~MappedFile();
+
+	MappedFile(MappedFile const &) = delete;
+	MappedFile &operator=(MappedFile const &) = delete;
+
+	char const *data = nullptr;
+	size_t size = 0;
+
+	//--- internals ---
+	#if defined(_WIN32)
+	void *file = nullptr; //HANDLE
+	void *mapping = nullptr; //HANDLE
+	#endif
+};
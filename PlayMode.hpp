@@ -2,16 +2,19 @@
 
 #include "Scene.hpp"
 #include "Sound.hpp"
+#include "TextBatch.hpp"
+#include "FontManager.hpp"
+#include "StringPool.hpp"
+#include "Playthrough.hpp"
+#include "FileWatcher.hpp"
 
 #include <glm/glm.hpp>
-#include <hb.h>
-#include <hb-ft.h>
-#include <freetype/freetype.h>
 
 #include <vector>
 #include <unordered_map>
-#include <set>
 #include <deque>
+#include <filesystem>
+#include <memory>
 
 struct PlayMode : Mode {
 	PlayMode();
@@ -21,142 +24,68 @@ struct PlayMode : Mode {
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
-	void render_at(std::string txt, float x, float y, glm::uvec2 const& drawable_size);
+	//queue txt (a string_pool handle; the text may contain RichText markup) for drawing with its (first) baseline starting at (x,y), 'size' pixels tall;
+	// lines are wrapped to fit in 'max_width' pixels (if > 0) and aligned with 'align';
+	// text outside of any <c=...> tag is drawn in text_color;
+	// returns false if the glyph atlas filled up:
+	bool render_at(StringPool::Handle txt, float x, float y, float size, float max_width = 0.0f, TextLayout::Align align = TextLayout::AlignLeft, FontManager::Style style = FontManager::Italic);
+	//same, for plain text that changes every frame (not interned or cached; markup is drawn as-is):
+	bool render_transient_at(std::string_view txt, float x, float y, float size, float max_width = 0.0f, TextLayout::Align align = TextLayout::AlignLeft, FontManager::Style style = FontManager::Italic);
+	//queue glyphs from 'layout' (in their markup styles + colors) scaled by 'scale':
+	bool render_layout(TextLayout::Result const &layout, float x, float y, float scale, FontManager::Style style);
 
 	//----- game state -----
 
 	// Scene/cameras
 	Scene scene;
-	Scene::Camera* prison_camera = nullptr;
-	Scene::Camera* coast_camera = nullptr;
-	Scene::Camera* table_camera = nullptr;
-	Scene::Camera* dungeon_camera = nullptr;
-	Scene::Camera* guard_camera = nullptr;
-	Scene::Camera* crate_camera = nullptr;
-	Scene::Camera* forest_camera = nullptr;
-	Scene::Camera* deeper_forest_camera = nullptr;
-	Scene::Camera* coastguard_camera = nullptr;
-	Scene::Camera* oar_camera = nullptr;
-	Scene::Camera* raft_camera = nullptr;
-	Scene::Camera* ship_camera = nullptr;
+	std::vector< Scene::Camera * > cameras; //in scene order (story locations name their camera by index)
 	Scene::Camera* camera = nullptr;
 
-	// Text shaping
-	FT_Library ft_library;
-	FT_Face ft_face;
-	hb_font_t* hb_font;
-	hb_buffer_t* hb_buffer;
-	std::unordered_map<hb_codepoint_t, GLuint> texture_map;
-
-	// Game state
-	enum Location {
-		PRISON,
-		DUNGEON,
-		TABLE,
-		GUARDS,
-		COAST,
-		COASTGUARDS,
-		CRATE,
-		SHIP,
-		FOREST,
-		DEEPWOODS,
-		OAR_LOC,
-		RAFT
-	} current_location;
+	// Text drawing (fonts, shaping, and glyphs are shared by all modes; see FontManager.hpp)
+	static constexpr uint32_t FontSize = 36; //text size (in pixels) when the window is 720 pixels tall
+	glm::u8vec4 text_color = glm::u8vec4(0x33, 0xcc, 0x99, 0xff);
+	TextBatch text_batch;
 
+	// Text drawing counters (toggle display with F3)
+	TextBatch::Stats text_stats;
+	uint32_t frame_number = 0;
+	bool show_text_stats = false;
+
+	// Game state (the plot itself is data; see Story.hpp and dist/story.txt, and Playthrough.hpp for the rules)
 	enum Choice {
-		LEFT,
+		LEFT, //(same values as Story::Side)
 		RIGHT,
 		NONE
 	} current_choice;
 
-	enum Item {
-		SWORD,
-		ROCK,
-		SHOVEL,
-		OAR,
-		KEY
-	};
-
-	std::set<Item> items;
-	
-	std::string message;
-	std::string result;
-	std::string left_choice;
-	std::string right_choice;
-
-	float time_to_crate = 0.0f;
-	float elapsed_time = 0.0f;
-
-	bool past_guard = false;
-	bool injured = false;
-	bool buddy = false;
-
-	// Location messages
-	std::string IN_PRISON_MESSAGE = "You are in the prison. What do you do to escape?";
-	std::string AT_TABLE_MESSAGE = "You are at the table. Where do you go?";
-	std::string NEAR_GUARDS_MESSAGE = "You are near the guards. What do you do?";
-	std::string DUNGEON_MESSAGE = "You are in the dungeon. Where do you go?";
-	std::string COAST_MESSAGE = "You are on the coast. What do you do?";
-	std::string CRATE_MESSAGE = "You are by the crate. Where to next?";
-	std::string FOREST_MESSAGE = "You are in the forest. What do you do?";
-	std::string DEEPWOODS_MESSAGE = "You are deep in the forest. Where do you go?";
-	std::string OAR_MESSAGE = "You are by an oar. Where to next?";
-	std::string RAFT_MESSAGE = "You are by the raft but have nothing to sail with. What do you do?";
-	std::string RAFT_WIN = "You are by the raft and have an oar. Congratulations!";
-	std::string SHIP_MESSAGE = "You have found a ship to escape on. Congratulations!";
-
-	// Choices
-	std::string GIVE_UP_CHOICE = "Give up.";
-	std::string GO_BACK_CHOICE = "Go back.";
-	std::string NO_CHOICE = "";
-	// Left choices
-	std::string DIG_TUNNEL_CHOICE = "Dig a tunnel.";
-	std::string ASK_NICELY_CHOICE = "Ask him nicely to let you go.";
-	std::string LOOK_AROUND_CHOICE = "Look around.";
-	std::string TURN_LEFT_CHOICE = "Turn left.";
-	std::string TRY_RIGHT_CHOICE = "Go right this time.";
-	std::string CHARGE_CHOICE = "Charge!";
-	std::string DEEPER_CHOICE = "Keep going deeper.";
-
-	// Right choices
-	std::string CALL_GUARD_CHOICE = "Call the guard.";
-	std::string ATTACK_GUARD_CHOICE = "Attack him!";
-	std::string USE_ROCK_CHOICE = "Use the rock.";
-	std::string TURN_RIGHT_CHOICE = "Turn right.";
-	std::string CELL_RETURN_CHOICE = "Back to the cell.";
-	std::string DISTRACTION_CHOICE = "Cause a distraction.";
-	std::string TRY_LEFT_CHOICE = "Go left this time.";
-
-	// Results
-	std::string GIVE_UP_RESULT = "It's a tough game for sure! Game over.";
-	std::string DEFAULT_RESULT = "Good luck!";
-	// Part 1
-	std::string NO_ITEM_RESULT = "With what? Nice try.";
-	std::string LOOK_AROUND_RESULT = "You see a rock and pick it up.";
-	std::string CALL_GUARD_RESULT = "The guard approaches.";
-	std::string GUARD_LEAVES_RESULT = "The guard leaves and won't come back. Game over.";
-	std::string KNOCK_OUT_RESULT = "The guard is knocked out. You take and use the key.";
-	std::string LEFT_TURN_RESULT = "You see a table. There is a sword and shovel.";
-	std::string RIGHT_TURN_RESULT = "You see two guards.";
-	std::string LEFT_CELL_RESULT = "You use the shovel to dig your way out of the prison.";
-	std::string RIGHT_CELL_RESULT = "Guess captivity is preferable to death.";
-	std::string DISTRACTION_SHOVEL_RESULT = "You throw the shovel and sneak by the guards.";
-	std::string DISTRACTION_ROCK_RESULT = "You throw the rock and sneak by the guards.";
-	std::string FIGHT_NO_SWORD_RESULT = "You die. Game over.";
-	std::string FIGHT_SWORD_RESULT = "You use the sword to beat them, but now you're injured.";
-	// Part 2
-	std::string CRATE_TTC_RESULT = "You see a crate! You take the key inside. Time to crate ";
-	std::string CRATE_RESULT = "You've returned to the crate.";
-	std::string DEEPER_RESULT = "There is no turning back now.";
-	std::string FOUND_OAR_RESULT = "You see and pick up an oar.";
-	std::string NOTHING_ELSE_RESULT = "There is nothing to see here.";
-	std::string SHIP_RESULT = "You beat them and reach the ship.";
-	std::string FOREST_RESULT = "You are in a forest.";
-	std::string FOREST_CREW_LOCKED_RESULT = "Your crewmate is locked up.";
-	std::string FOREST_CREW_FREE_RESULT = "Your crewmate is locked up. You use your key to free him.";
-	std::string COAST_RETURN_RESULT = "You are back on the coast.";
-	std::string DEEP_RETURN_RESULT = "You are back in the deep woods.";
-	std::string RAFT_NO_OAR_RESULT = "You have found a raft but have nothing to sail with.";
-	std::string RAFT_OAR_RESULT = "You have found a raft and use the oar.";
+	Playthrough play;
+
+	StringPool::Handle result_text = StringPool::Invalid; //what is drawn for play.result (with any "{time}" filled in)
+
+	//snapshots from before each choice / restart (Backspace rewinds to the last one):
+	SnapshotRing history;
+	//quick save file (F5 saves, F9 loads):
+	std::string save_file;
+
+	//story hot reload: when story.bin changes, map the new one and carry on (see Playthrough::switch_story);
+	// when story.txt changes, compile it to story.bin first:
+	std::string story_file;
+	std::string story_source_file;
+	std::filesystem::file_time_type story_file_time; //modification time of the story.bin in use
+	std::unique_ptr< FileWatcher > story_watcher;
+	//the story being played: the shared Load< Story > until a reload, then this mode's own copy:
+	// (the Load<> is never replaced, so other modes -- and later PlayModes -- keep a valid story)
+	Story const *active_story;
+	std::unique_ptr< Story > reloaded_story;
+	void reload_story(bool recompile);
+	static std::filesystem::file_time_type file_time(std::string const &path); //(min() if missing)
+
+	//start the story over:
+	void restart();
+	//match the camera + result text to play (after it changes):
+	void sync();
+
+	//story string id -> string_pool handle (interned the first time it is needed):
+	std::vector< StringPool::Handle > story_text;
+	StringPool::Handle text(uint32_t id);
 };
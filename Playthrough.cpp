@@ -0,0 +1,157 @@
+#include "Playthrough.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+static constexpr std::string_view TimePlaceholder = "{time}";
+
+Playthrough::Playthrough(Story const &story_) : story(&story_) {
+	restart();
+}
+
+void Playthrough::restart() {
+	state = story->start();
+	result = story->start_result;
+	elapsed_time = 0.0f;
+	time_to_crate = 0.0f;
+}
+
+bool Playthrough::result_needs_format() const {
+	return story->string(result).find(TimePlaceholder) != std::string_view::npos;
+}
+
+std::string Playthrough::format_result() const {
+	std::string_view str = story->string(result);
+	std::string ret;
+	for (size_t at = 0; at < str.size(); /* later */) {
+		size_t found = str.find(TimePlaceholder, at);
+		if (found == std::string_view::npos) found = str.size();
+		ret += str.substr(at, found - at);
+		if (found < str.size()) {
+			ret += std::to_string((size_t)time_to_crate);
+			found += TimePlaceholder.size();
+		}
+		at = found;
+	}
+	return ret;
+}
+
+Playthrough::Snapshot Playthrough::snapshot() const {
+	Snapshot ret;
+	ret.state = state;
+	ret.result = result;
+	ret.elapsed_time = elapsed_time;
+	ret.time_to_crate = time_to_crate;
+	ret.reserved = 0;
+	return ret;
+}
+
+void Playthrough::restore(Snapshot const &from) {
+	GameState const &s = from.state;
+	if (s.node >= story->nodes.size()) {
+		throw std::runtime_error("Snapshot is at node " + std::to_string(s.node) + ", but the story has " + std::to_string(story->nodes.size()) + ".");
+	}
+	if (s.location != story->nodes[s.node].location) {
+		throw std::runtime_error("Snapshot location " + std::to_string(s.location) + " doesn't match its node.");
+	}
+	if (story->bits.size() < Story::MaxBits && (s.bits >> story->bits.size()) != 0) {
+		throw std::runtime_error("Snapshot has state bits the story doesn't use.");
+	}
+	if (from.result >= story->strings.size()) {
+		throw std::runtime_error("Snapshot result is string " + std::to_string(from.result) + ", but the story has " + std::to_string(story->strings.size()) + ".");
+	}
+	state = s;
+	result = from.result;
+	elapsed_time = from.elapsed_time;
+	time_to_crate = from.time_to_crate;
+}
+
+bool Playthrough::switch_story(Story const &next) {
+	Story const &prev = *story;
+
+	uint32_t node = next.find_node(prev.string(prev.nodes[state.node].name));
+	if (node == Story::Invalid) {
+		story = &next;
+		restart();
+		return false;
+	}
+
+	//state bits may have been added, removed, or reordered:
+	uint64_t bits = 0;
+	for (uint32_t b = 0; b < prev.bits.size(); ++b) {
+		if (!(state.bits & (uint64_t(1) << b))) continue;
+		uint32_t found = next.find_bit(prev.string(prev.bits[b].name));
+		if (found != Story::Invalid) bits |= (uint64_t(1) << found);
+	}
+
+	//result text may have moved (or changed, in which case fall back to the start text):
+	std::string_view text = prev.string(result);
+	uint32_t next_result = next.start_result;
+	for (uint32_t s = 0; s < next.strings.size(); ++s) {
+		if (next.string(s) == text) {
+			next_result = s;
+			break;
+		}
+	}
+
+	story = &next;
+	state.bits = bits;
+	state.node = node;
+	state.location = next.nodes[node].location;
+	result = next_result;
+	return true;
+}
+
+//Save files are two chunks:
+//  pls0: SaveHeader
+//  snp0: one Snapshot
+//The header records the story's shape, so saves from a different story are refused rather than misread:
+struct SaveHeader {
+	uint32_t version; //Playthrough::SaveVersion
+	uint32_t nodes, edges, strings; //counts in the story the save was made with
+};
+static_assert(sizeof(SaveHeader) == 16, "SaveHeader is packed");
+
+void Playthrough::save(std::string const &filename) const {
+	SaveHeader header;
+	header.version = SaveVersion;
+	header.nodes = uint32_t(story->nodes.size());
+	header.edges = uint32_t(story->edges.size());
+	header.strings = uint32_t(story->strings.size());
+
+	std::string temp = filename + ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary);
+		write_chunk("pls0", std::vector< SaveHeader >{ header }, &out);
+		write_chunk("snp0", std::vector< Snapshot >{ snapshot() }, &out);
+		out.close();
+		if (!out) throw std::runtime_error("Failed to write save '" + temp + "'.");
+	}
+	std::error_code ec;
+	std::filesystem::rename(temp, filename, ec);
+	if (ec) throw std::runtime_error("Failed to replace save '" + filename + "': " + ec.message());
+}
+
+void Playthrough::load(std::string const &filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in) throw std::runtime_error("Failed to open save '" + filename + "'.");
+
+	std::vector< SaveHeader > header;
+	read_chunk(in, "pls0", &header);
+	if (header.size() != 1) throw std::runtime_error("Save '" + filename + "' has a malformed header.");
+	if (header[0].version != SaveVersion) {
+		throw std::runtime_error("Save '" + filename + "' has version " + std::to_string(header[0].version) + ", expected " + std::to_string(SaveVersion) + ".");
+	}
+	if (header[0].nodes != story->nodes.size() || header[0].edges != story->edges.size() || header[0].strings != story->strings.size()) {
+		throw std::runtime_error("Save '" + filename + "' was made with a different story.");
+	}
+
+	std::vector< Snapshot > snapshots;
+	read_chunk(in, "snp0", &snapshots);
+	if (snapshots.size() != 1) throw std::runtime_error("Save '" + filename + "' should hold one snapshot, but has " + std::to_string(snapshots.size()) + ".");
+
+	restore(snapshots[0]);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+/*
+ * A Playthrough is one player's progress through a Story: the GameState,
+ *  the result of the last choice, and the clock (for time-to-crate).
+ *
+ * It is the whole of the game's logic, with no GL, fonts, or scene, so the
+ *  same rules run in PlayMode and in command-line tools (see story-sim.cpp).
+ *
+ * Everything that changes during play fits in a 32-byte Snapshot, which is
+ *  what save files hold and what SnapshotRing keeps for rewinding.
+ *
+ */
+
+#include "Story.hpp"
+#include "GameState.hpp"
+
+#include <array>
+#include <string>
+#include <type_traits>
+
+struct Playthrough {
+	Playthrough(Story const &story);
+
+	Story const *story; //(changes when the story is reloaded; see switch_story)
+
+	GameState state;
+	uint32_t result = 0; //story string describing the last choice
+	float elapsed_time = 0.0f; //since the (re)start
+	float time_to_crate = 0.0f; //elapsed_time when ActionRecordTime last happened
+
+	//start over:
+	void restart();
+
+	//let time pass:
+	void tick(float elapsed) {
+		elapsed_time += elapsed;
+	}
+
+	//make a choice; returns the edge taken (or Story::Invalid if the choice does nothing here):
+	uint32_t choose(Story::Side side) {
+		uint32_t e = story->choose(state, side);
+		if (e != Story::Invalid) {
+			Story::Edge const &edge = story->edges[e];
+			if (edge.actions & Story::ActionRecordTime) {
+				time_to_crate = elapsed_time;
+			}
+			state = story->take(state, e);
+			result = edge.result;
+		}
+		return e;
+	}
+
+	//no choice does anything from here:
+	bool ended() const {
+		return story->is_ending(state.node);
+	}
+
+	//does the result text need formatting (i.e., does it have a "{time}" in it)?
+	bool result_needs_format() const;
+	//result text with "{time}" replaced by the time to crate in whole seconds:
+	std::string format_result() const;
+
+	//everything above that changes during play, as one flat record:
+	struct Snapshot {
+		GameState state;
+		uint32_t result;
+		float elapsed_time;
+		float time_to_crate;
+		uint32_t reserved; //(keeps Snapshot a multiple of 8 bytes)
+	};
+	Snapshot snapshot() const;
+	//resume from a snapshot; throws (leaving the playthrough as it was) if it doesn't fit the story:
+	void restore(Snapshot const &from);
+
+	//save file format version:
+	static constexpr uint32_t SaveVersion = 1;
+
+	//move to another version of the story (e.g., after it was edited and reloaded), keeping what carries over:
+	// the node, state bits, and result text are matched by name (and text); if the node is gone, starts over.
+	// returns true if the node was kept:
+	bool switch_story(Story const &next);
+
+	//write a snapshot to 'filename' (written to a temporary file, then renamed over 'filename', so a failed save never clobbers the old one):
+	void save(std::string const &filename) const;
+	//restore a snapshot written by save(); throws on error:
+	void load(std::string const &filename);
+};
+
+static_assert(sizeof(Playthrough::Snapshot) == 32, "Snapshot is packed");
+static_assert(std::is_trivially_copyable< Playthrough::Snapshot >::value, "Snapshot can be copied as bytes");
+
+//The most recent snapshots (up to Capacity of them; older ones are dropped), for rewinding:
+struct SnapshotRing {
+	static constexpr uint32_t Capacity = 256;
+
+	//remember a snapshot:
+	void push(Playthrough::Snapshot const &snapshot) {
+		snapshots[(first + count) % Capacity] = snapshot;
+		if (count < Capacity) count += 1;
+		else first = (first + 1) % Capacity;
+	}
+	//take back the most recent snapshot; returns false if there are none:
+	bool pop(Playthrough::Snapshot *snapshot) {
+		if (count == 0) return false;
+		count -= 1;
+		*snapshot = snapshots[(first + count) % Capacity];
+		return true;
+	}
+	void clear() {
+		first = count = 0;
+	}
+
+	std::array< Playthrough::Snapshot, Capacity > snapshots;
+	uint32_t first = 0; //oldest snapshot
+	uint32_t count = 0;
+};
@@ -0,0 +1,93 @@
+#include "RichText.hpp"
+
+#include <cassert>
+#include <cstring>
+
+static bool starts_with(std::string_view str, size_t at, char const *prefix) {
+	size_t len = std::strlen(prefix);
+	return at + len <= str.size() && str.compare(at, len, prefix) == 0;
+}
+
+static int hex_digit(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+//if a "<c=rrggbb>" tag starts at 'at', store its color and return true:
+static bool parse_color_tag(std::string_view str, size_t at, glm::u8vec4 *color) {
+	if (!starts_with(str, at, "<c=") || at + 10 > str.size() || str[at + 9] != '>') return false;
+	glm::u8vec4 ret = glm::u8vec4(0xff);
+	for (uint32_t i = 0; i < 3; ++i) {
+		int hi = hex_digit(str[at + 3 + 2 * i]);
+		int lo = hex_digit(str[at + 3 + 2 * i + 1]);
+		if (hi < 0 || lo < 0) return false;
+		ret[i] = uint8_t(hi * 16 + lo);
+	}
+	*color = ret;
+	return true;
+}
+
+void RichText::parse(std::string_view markup, std::vector< Span > *spans_) {
+	assert(spans_);
+	auto &spans = *spans_;
+	spans.clear();
+
+	uint32_t bold = 0; //(count, so <b><b>..</b></b> works)
+	glm::u8vec4 colors[MaxDepth];
+	uint32_t depth = 0; //number of open <c=...> tags (may exceed MaxDepth; deeper ones are ignored)
+
+	Span current;
+	auto flush = [&](size_t end) {
+		current.end = uint32_t(end);
+		if (current.end > current.begin) spans.emplace_back(current);
+	};
+	auto restart = [&](size_t begin) {
+		current.begin = uint32_t(begin);
+		current.bold = (bold > 0);
+		uint32_t top = (depth < MaxDepth ? depth : MaxDepth);
+		current.has_color = (top > 0);
+		current.color = (top > 0 ? colors[top - 1] : glm::u8vec4(0xff));
+	};
+	restart(0);
+
+	for (size_t i = 0; i < markup.size(); /* later */) {
+		if (markup[i] != '<') {
+			++i;
+			continue;
+		}
+		glm::u8vec4 color;
+		size_t tag_length = 0;
+		if (starts_with(markup, i, "<b>")) {
+			bold += 1;
+			tag_length = 3;
+		} else if (starts_with(markup, i, "</b>")) {
+			if (bold > 0) bold -= 1;
+			tag_length = 4;
+		} else if (parse_color_tag(markup, i, &color)) {
+			if (depth < MaxDepth) colors[depth] = color;
+			depth += 1;
+			tag_length = 10;
+		} else if (starts_with(markup, i, "</c>")) {
+			if (depth > 0) depth -= 1;
+			tag_length = 4;
+		} else {
+			++i; //not a tag; just text
+			continue;
+		}
+		flush(i);
+		i += tag_length;
+		restart(i);
+	}
+	flush(markup.size());
+}
+
+bool RichText::is_plain(std::string_view markup) {
+	for (size_t i = markup.find('<'); i != std::string_view::npos; i = markup.find('<', i + 1)) {
+		glm::u8vec4 color;
+		if (starts_with(markup, i, "<b>") || starts_with(markup, i, "</b>")
+		 || starts_with(markup, i, "</c>") || parse_color_tag(markup, i, &color)) return false;
+	}
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+/*
+ * RichText splits a string with (very) minimal markup into styled spans:
+ *
+ *   <b>...</b>          bold
+ *   <c=rrggbb>...</c>   color, as hex (may be nested, up to MaxDepth deep)
+ *
+ * Anything that isn't one of these exact tags (e.g., a lone '<') is plain text.
+ *
+ * Spans refer to byte ranges of the original string (tags are never inside a
+ *  span), so glyphs shaped from a span can keep offsets into the markup.
+ *
+ */
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct RichText {
+	struct Span {
+		uint32_t begin = 0, end = 0; //byte range [begin,end) of the markup
+		bool bold = false;
+		bool has_color = false; //if false, draw in the caller's default color
+		glm::u8vec4 color = glm::u8vec4(0xff);
+	};
+
+	static constexpr uint32_t MaxDepth = 8; //deepest <c=...> nesting that is tracked
+
+	//split 'markup' into spans (replacing the contents of 'spans'); empty spans are skipped:
+	static void parse(std::string_view markup, std::vector< Span > *spans);
+
+	//true if 'markup' has no tags at all (i.e., parse() would return at most one plain span):
+	static bool is_plain(std::string_view markup);
+};
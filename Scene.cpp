@@ -2,14 +2,19 @@
 
 #include "gl_errors.hpp"
 #include "read_write_chunk.hpp"
+#include "world_matrices.hpp"
+#include "WorkerPool.hpp"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <fstream>
+#include <type_traits>
 
 //-------------------------
 
-glm::mat4x3 Scene::Transform::make_local_to_parent() const {
+//local-to-parent and parent-to-local matrices of a transform with the given properties:
+static glm::mat4x3 local_to_parent(glm::vec3 const &position, glm::quat const &rotation, glm::vec3 const &scale) {
 	//compute:
 	//   translate   *   rotate    *   scale
 	// [ 1 0 0 p.x ]   [       0 ]   [ s.x 0 0 0 ]
@@ -26,7 +31,7 @@ glm::mat4x3 Scene::Transform::make_local_to_parent() const {
 	);
 }
 
-glm::mat4x3 Scene::Transform::make_parent_to_local() const {
+static glm::mat4x3 parent_to_local(glm::vec3 const &position, glm::quat const &rotation, glm::vec3 const &scale) {
 	//compute:
 	//   1/scale       *    rot^-1   *  translate^-1
 	// [ 1/s.x 0 0 0 ]   [       0 ]   [ 0 0 0 -p.x ]
@@ -56,19 +61,130 @@ glm::mat4x3 Scene::Transform::make_parent_to_local() const {
 	);
 }
 
-glm::mat4x3 Scene::Transform::make_local_to_world() const {
-	if (!parent) {
-		return make_local_to_parent();
-	} else {
-		return parent->make_local_to_world() * glm::mat4(make_local_to_parent()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+glm::mat4x3 Scene::Transforms::make_local_to_parent(Transform transform) const {
+	uint32_t i = index(transform);
+	return local_to_parent(positions[i], rotations[i], scales[i]);
+}
+
+glm::mat4x3 Scene::Transforms::make_parent_to_local(Transform transform) const {
+	uint32_t i = index(transform);
+	return parent_to_local(positions[i], rotations[i], scales[i]);
+}
+
+Scene::Transform Scene::Transforms::add(std::string const &name, Transform parent) {
+	Transform transform{ uint32_t(indices.size()) };
+	uint32_t i = size();
+	indices.emplace_back(i);
+	handles.emplace_back(transform.handle);
+
+	names.emplace_back(name);
+	positions.emplace_back(0.0f);
+	rotations.emplace_back(1.0f, 0.0f, 0.0f, 0.0f);
+	scales.emplace_back(1.0f);
+	//(the parent, if any, is already stored, so it comes first)
+	parents.emplace_back(parent ? index(parent) : None);
+	local_to_worlds.emplace_back(1.0f);
+	world_to_locals.emplace_back(1.0f);
+	dirty.emplace_back(0);
+	changed(i);
+	levels.clear(); //(may no longer be sorted by depth)
+
+	return transform;
+}
+
+void Scene::Transforms::set_parent(Transform transform, Transform parent) {
+	uint32_t i = index(transform);
+	uint32_t p = (parent ? index(parent) : None);
+	//no cycles:
+	for (uint32_t a = p; a != None; a = parents[a]) {
+		assert(a != i && "set_parent would create a cycle");
 	}
+	parents[i] = p;
+	changed(i);
+	levels.clear(); //(depths changed)
+	//parent is stored after its new child? re-sort:
+	if (p != None && p > i) sort();
 }
-glm::mat4x3 Scene::Transform::make_world_to_local() const {
-	if (!parent) {
-		return make_parent_to_local();
+
+void Scene::Transforms::sort() {
+	//depth of each transform in the hierarchy:
+	// (parents may currently be stored after their children, so follow chains upward)
+	std::vector< uint32_t > depth(size(), None);
+	std::vector< uint32_t > chain;
+	for (uint32_t i = 0; i < size(); ++i) {
+		uint32_t at = i;
+		while (at != None && depth[at] == None) {
+			chain.emplace_back(at);
+			at = parents[at];
+		}
+		uint32_t d = (at == None ? 0 : depth[at] + 1);
+		while (!chain.empty()) {
+			depth[chain.back()] = d;
+			d += 1;
+			chain.pop_back();
+		}
+	}
+
+	//new storage order: by depth (stable, so siblings keep their relative order):
+	std::vector< uint32_t > order(size());
+	for (uint32_t i = 0; i < size(); ++i) order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&depth](uint32_t a, uint32_t b) {
+		return depth[a] < depth[b];
+	});
+
+	//first transform at each depth:
+	levels.clear();
+	for (uint32_t i = 0; i < size(); ++i) {
+		while (levels.size() <= depth[order[i]]) levels.emplace_back(i);
+	}
+	levels.emplace_back(size());
+
+	std::vector< uint32_t > new_index(size());
+	for (uint32_t i = 0; i < size(); ++i) new_index[order[i]] = i;
+
+	auto permute = [&order](auto &array) {
+		typename std::remove_reference< decltype(array) >::type sorted;
+		sorted.reserve(array.size());
+		for (uint32_t o : order) sorted.emplace_back(std::move(array[o]));
+		array = std::move(sorted);
+	};
+	permute(names);
+	permute(positions);
+	permute(rotations);
+	permute(scales);
+	permute(parents);
+	permute(handles);
+	for (auto &p : parents) {
+		if (p != None) p = new_index[p];
+	}
+	for (uint32_t i = 0; i < size(); ++i) {
+		indices[handles[i]] = i;
+	}
+
+	//(cached matrices are recomputed rather than permuted)
+	std::fill(dirty.begin(), dirty.end(), uint8_t(1));
+	any_dirty = true;
+}
+
+//threads for updating large scenes (started the first time one is updated):
+static WorkerPool &world_pool() {
+	static WorkerPool pool;
+	return pool;
+}
+
+void Scene::Transforms::update_world() const {
+	if (!any_dirty) return;
+	//parents are stored before children, so one pass (several transforms at a time) brings everything up to date:
+	if (!levels.empty() && size() >= ParallelSize && world_pool().size() > 1) {
+		//...or, when sorted by depth, one pass per depth level, split across threads:
+		update_world_matrices(world_pool(), uint32_t(levels.size()) - 1, levels.data(),
+			positions.data(), rotations.data(), scales.data(), parents.data(),
+			dirty.data(), local_to_worlds.data(), world_to_locals.data());
 	} else {
-		return make_parent_to_local() * glm::mat4(parent->make_world_to_local()); //note: glm::mat4(glm::mat4x3) pads with a (0,0,0,1) row
+		update_world_matrices(size(), positions.data(), rotations.data(), scales.data(), parents.data(),
+			dirty.data(), local_to_worlds.data(), world_to_locals.data());
 	}
+	any_dirty = false;
 }
 
 //-------------------------
@@ -82,13 +198,43 @@ glm::mat4 Scene::Camera::make_projection() const {
 
 void Scene::draw(Camera const &camera) const {
 	assert(camera.transform);
-	glm::mat4 world_to_clip = camera.make_projection() * glm::mat4(camera.transform->make_world_to_local());
+	glm::mat4 world_to_clip = camera.make_projection() * glm::mat4(transforms.world_to_local(camera.transform));
 	glm::mat4x3 world_to_light = glm::mat4x3(1.0f);
 	draw(world_to_clip, world_to_light);
 }
 
+//is a local-space box entirely outside the view? (i.e., on the outside of one of the planes)
+static bool outside(glm::vec4 const planes[6], glm::vec3 const &min, glm::vec3 const &max, glm::mat4x3 const &local_to_world) {
+	//world-space box (as a center and half-size) that holds the transformed box:
+	glm::vec3 center = local_to_world * glm::vec4(0.5f * (min + max), 1.0f);
+	glm::vec3 half = 0.5f * (max - min);
+	glm::vec3 radius = glm::abs(local_to_world[0]) * half.x + glm::abs(local_to_world[1]) * half.y + glm::abs(local_to_world[2]) * half.z;
+	for (uint32_t i = 0; i < 6; ++i) {
+		glm::vec3 normal = glm::vec3(planes[i]);
+		//the box's most-inside corner is still outside?
+		if (glm::dot(normal, center) + planes[i].w + glm::dot(glm::abs(normal), radius) < 0.0f) return true;
+	}
+	return false;
+}
+
 void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light) const {
 
+	//bring world matrices up to date (in one pass) before looking them up:
+	transforms.update_world();
+
+	//world-space planes bounding the view (from the rows of world_to_clip, as in Gribb & Hartmann,
+	// "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"):
+	// a point p is in view if dot(plane, vec4(p, 1)) >= 0 for every plane
+	// (for the infinite perspective used by Camera, the far plane accepts everything)
+	glm::mat4 rows = glm::transpose(world_to_clip);
+	glm::vec4 const planes[6] = {
+		rows[3] + rows[0], rows[3] - rows[0], //left, right
+		rows[3] + rows[1], rows[3] - rows[1], //bottom, top
+		rows[3] + rows[2], rows[3] - rows[2], //near, far
+	};
+	drawn = 0;
+	culled = 0;
+
 	//Iterate through all drawables, sending each one to OpenGL:
 	for (auto const &drawable : drawables) {
 		//Reference to drawable's pipeline for convenience:
@@ -101,6 +247,16 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 		//skip any drawables that don't contain any vertices:
 		if (pipeline.count == 0) continue;
 
+		//the object-to-world matrix is used for culling and in all three of the uniforms below:
+		assert(drawable.transform); //drawables *must* have a transform
+		glm::mat4x3 const &object_to_world = transforms.local_to_worlds[transforms.index(drawable.transform)];
+
+		//skip any drawables that are entirely out of view:
+		if (drawable.min.x <= drawable.max.x && outside(planes, drawable.min, drawable.max, object_to_world)) {
+			culled += 1;
+			continue;
+		}
+		drawn += 1;
 
 		//Set shader program:
 		glUseProgram(pipeline.program);
@@ -110,10 +266,6 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 		//Configure program uniforms:
 
-		//the object-to-world matrix is used in all three of these uniforms:
-		assert(drawable.transform); //drawables *must* have a transform
-		glm::mat4x3 object_to_world = drawable.transform->make_local_to_world();
-
 		//OBJECT_TO_CLIP takes vertices from object space to clip space:
 		if (pipeline.OBJECT_TO_CLIP_mat4 != -1U) {
 			glm::mat4 object_to_clip = world_to_clip * glm::mat4(object_to_world);
@@ -167,7 +319,7 @@ void Scene::draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_lig
 
 
 void Scene::load(std::string const &filename,
-	std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
+	std::function< void(Scene &, Transform, std::string const &) > const &on_drawable) {
 
 	std::ifstream file(filename, std::ios::binary);
 
@@ -221,33 +373,34 @@ void Scene::load(std::string const &filename,
 	//--------------------------------
 	//Now that file is loaded, create transforms for hierarchy entries:
 
-	std::vector< Transform * > hierarchy_transforms;
+	std::vector< Transform > hierarchy_transforms;
 	hierarchy_transforms.reserve(hierarchy.size());
 
 	for (auto const &h : hierarchy) {
-		transforms.emplace_back();
-		Transform *t = &transforms.back();
+		Transform parent;
 		if (h.parent != -1U) {
 			if (h.parent >= hierarchy_transforms.size()) {
 				throw std::runtime_error("scene file '" + filename + "' did not contain transforms in topological-sort order.");
 			}
-			t->parent = hierarchy_transforms[h.parent];
+			parent = hierarchy_transforms[h.parent];
 		}
 
-		if (h.name_begin <= h.name_end && h.name_end <= names.size()) {
-			t->name = std::string(names.begin() + h.name_begin, names.begin() + h.name_end);
-		} else {
+		if (!(h.name_begin <= h.name_end && h.name_end <= names.size())) {
 				throw std::runtime_error("scene file '" + filename + "' contains hierarchy entry with invalid name indices");
 		}
 
-		t->position = h.position;
-		t->rotation = h.rotation;
-		t->scale = h.scale;
+		Transform t = transforms.add(std::string(names.begin() + h.name_begin, names.begin() + h.name_end), parent);
+		transforms.set_position(t, h.position);
+		transforms.set_rotation(t, h.rotation);
+		transforms.set_scale(t, h.scale);
 
 		hierarchy_transforms.emplace_back(t);
 	}
 	assert(hierarchy_transforms.size() == hierarchy.size());
 
+	//group transforms by depth, so large scenes can update their world matrices in parallel:
+	transforms.sort();
+
 	for (auto const &m : meshes) {
 		if (m.transform >= hierarchy_transforms.size()) {
 			throw std::runtime_error("scene file '" + filename + "' contains mesh entry with invalid transform index (" + std::to_string(m.transform) + ")");
@@ -314,7 +467,7 @@ void Scene::load(std::string const &filename,
 
 //-------------------------
 
-Scene::Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable) {
+Scene::Scene(std::string const &filename, std::function< void(Scene &, Transform, std::string const &) > const &on_drawable) {
 	load(filename, on_drawable);
 }
 
@@ -327,51 +480,10 @@ Scene &Scene::operator=(Scene const &other) {
 	return *this;
 }
 
-void Scene::set(Scene const &other, std::unordered_map< Transform const *, Transform * > *transform_map_) {
-
-	std::unordered_map< Transform const *, Transform * > t2t_temp;
-	std::unordered_map< Transform const *, Transform * > &transform_to_transform = *(transform_map_ ? transform_map_ : &t2t_temp);
-
-	transform_to_transform.clear();
-
-	//null transform maps to itself:
-	transform_to_transform.insert(std::make_pair(nullptr, nullptr));
-
-	//Copy transforms and store mapping:
-	transforms.clear();
-	for (auto const &t : other.transforms) {
-		transforms.emplace_back();
-		transforms.back().name = t.name;
-		transforms.back().position = t.position;
-		transforms.back().rotation = t.rotation;
-		transforms.back().scale = t.scale;
-		transforms.back().parent = t.parent; //will update later
-
-		//store mapping between transforms old and new:
-		auto ret = transform_to_transform.insert(std::make_pair(&t, &transforms.back()));
-		assert(ret.second);
-	}
-
-	//update transform parents:
-	for (auto &t : transforms) {
-		t.parent = transform_to_transform.at(t.parent);
-	}
-
-	//copy other's drawables, updating transform pointers:
+void Scene::set(Scene const &other) {
+	//transforms are referred to by handle, which are the same in the copy, so everything copies as-is:
+	transforms = other.transforms;
 	drawables = other.drawables;
-	for (auto &d : drawables) {
-		d.transform = transform_to_transform.at(d.transform);
-	}
-
-	//copy other's cameras, updating transform pointers:
 	cameras = other.cameras;
-	for (auto &c : cameras) {
-		c.transform = transform_to_transform.at(c.transform);
-	}
-
-	//copy other's lights, updating transform pointers:
 	lights = other.lights;
-	for (auto &l : lights) {
-		l.transform = transform_to_transform.at(l.transform);
-	}
 }
@@ -15,44 +15,108 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 
-#include <list>
+#include <cassert>
 #include <memory>
 #include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 #include <unordered_map>
 
 struct Scene {
+	//Transforms are kept in Scene::transforms (a Transforms store, below) and referred to by handle:
+	// (handles stay valid as transforms are added or reordered, and name the same transforms in a copy of the scene)
 	struct Transform {
-		//Transform names are useful for debugging and looking up locations in a loaded scene:
-		std::string name;
+		Transform() : handle(-1U) { }
+		explicit Transform(uint32_t handle_) : handle(handle_) { }
+		uint32_t handle;
+		explicit operator bool() const { return handle != -1U; }
+		bool operator==(Transform const &other) const { return handle == other.handle; }
+		bool operator!=(Transform const &other) const { return handle != other.handle; }
+	};
 
-		//The core function of a transform is to store a transformation in the world:
-		glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f);
-		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f); //n.b. wxyz init order
-		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f);
+	//Transforms stores every transform's properties in separate contiguous arrays ("structure of arrays"),
+	// sorted so that parents come before their children. This means all world matrices can be brought
+	// up to date in one linear pass, with each parent's matrix already computed when its children need it.
+	struct Transforms {
+		//add a transform (with no parent, or a parent that already exists):
+		Transform add(std::string const &name = "", Transform parent = Transform());
+		uint32_t size() const { return uint32_t(handles.size()); }
 
-		//The transform above may be relative to some parent transform:
-		Transform *parent = nullptr;
+		//transforms in storage (parent-before-child) order, for passes over all of them:
+		Transform at(uint32_t index) const { return Transform{ handles[index] }; }
+		uint32_t index(Transform transform) const { assert(transform.handle < indices.size()); return indices[transform.handle]; }
 
-		//It is often convenient to construct matrices representing this transformation:
+		//The core function of a transform is to store a transformation in the world:
+		// (names are useful for debugging and looking up locations in a loaded scene)
+		std::string const &name(Transform transform) const { return names[index(transform)]; }
+		glm::vec3 const &position(Transform transform) const { return positions[index(transform)]; }
+		glm::quat const &rotation(Transform transform) const { return rotations[index(transform)]; }
+		glm::vec3 const &scale(Transform transform) const { return scales[index(transform)]; }
+		//...which may be relative to some parent transform:
+		Transform parent(Transform transform) const {
+			uint32_t p = parents[index(transform)];
+			return (p == None ? Transform() : at(p));
+		}
+
+		//changing a transform marks its world matrices (and its descendants') out of date:
+		void set_name(Transform transform, std::string const &name) { names[index(transform)] = name; }
+		void set_position(Transform transform, glm::vec3 const &position) { uint32_t i = index(transform); positions[i] = position; changed(i); }
+		void set_rotation(Transform transform, glm::quat const &rotation) { uint32_t i = index(transform); rotations[i] = rotation; changed(i); }
+		void set_scale(Transform transform, glm::vec3 const &scale) { uint32_t i = index(transform); scales[i] = scale; changed(i); }
+		//(reorders storage if the new parent is stored after 'transform')
+		void set_parent(Transform transform, Transform parent);
+
+		//It is often convenient to construct matrices representing a transformation:
 		// ..relative to its parent:
-		glm::mat4x3 make_local_to_parent() const;
-		glm::mat4x3 make_parent_to_local() const;
-		// ..relative to the world:
-		glm::mat4x3 make_local_to_world() const;
-		glm::mat4x3 make_world_to_local() const;
-
-		//since hierarchy is tracked through pointers, copy-constructing a transform  is not advised:
-		Transform(Transform const &) = delete;
-		//if we delete some constructors, we need to let the compiler know that the default constructor is still okay:
-		Transform() = default;
+		glm::mat4x3 make_local_to_parent(Transform transform) const;
+		glm::mat4x3 make_parent_to_local(Transform transform) const;
+		// ..relative to the world (cached; any out-of-date matrices are updated first):
+		glm::mat4x3 const &local_to_world(Transform transform) const { update_world(); return local_to_worlds[index(transform)]; }
+		glm::mat4x3 const &world_to_local(Transform transform) const { update_world(); return world_to_locals[index(transform)]; }
+
+		//bring out-of-date world matrices up to date (one pass over the arrays; does nothing if none changed):
+		// (stores of at least ParallelSize transforms that are sorted by depth split each depth level across a shared worker pool)
+		void update_world() const;
+		static constexpr uint32_t ParallelSize = 16384;
+
+		//re-sort storage by depth in the hierarchy, so that each depth level is a contiguous range that can be updated in parallel:
+		// (Scene::load does this; adding transforms or changing parents undoes it)
+		void sort();
+
+		//--- internals: per-transform arrays, in storage order ---
+		static constexpr uint32_t None = -1U;
+		std::vector< std::string > names;
+		std::vector< glm::vec3 > positions;
+		std::vector< glm::quat > rotations;
+		std::vector< glm::vec3 > scales;
+		std::vector< uint32_t > parents; //storage index of parent (or None)
+		mutable std::vector< glm::mat4x3 > local_to_worlds;
+		mutable std::vector< glm::mat4x3 > world_to_locals;
+		mutable std::vector< uint8_t > dirty; //world matrices out of date? (if so, the children's are too)
+		mutable bool any_dirty = false;
+
+		std::vector< uint32_t > handles; //storage index -> handle
+		std::vector< uint32_t > indices; //handle -> storage index
+
+		//if sorted by depth: levels[d] is the storage index of the first transform at depth d (and levels.back() == size()); otherwise empty
+		std::vector< uint32_t > levels;
+
+		void changed(uint32_t i) {
+			dirty[i] = 1;
+			any_dirty = true;
+		}
 	};
 
 	struct Drawable {
 		//a 'Drawable' attaches attribute data to a transform:
-		Drawable(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Drawable(Transform transform_) : transform(transform_) { assert(transform); }
+		Transform transform;
+
+		//bounding box in the transform's local space (e.g., a Mesh's min and max), used to skip drawables outside the view:
+		// (the default, an empty box with min > max, means "unknown"; such drawables are always drawn)
+		glm::vec3 min = glm::vec3( std::numeric_limits< float >::infinity());
+		glm::vec3 max = glm::vec3(-std::numeric_limits< float >::infinity());
 
 		//Contains all the data needed to run the OpenGL pipeline:
 		struct Pipeline {
@@ -83,8 +147,8 @@ struct Scene {
 
 	struct Camera {
 		//a 'Camera' attaches camera data to a transform:
-		Camera(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Camera(Transform transform_) : transform(transform_) { assert(transform); }
+		Transform transform;
 		//NOTE: cameras are directed along their -z axis
 
 		//perspective camera parameters:
@@ -97,8 +161,8 @@ struct Scene {
 
 	struct Light {
 		//a 'Light' attaches light data to a transform:
-		Light(Transform *transform_) : transform(transform_) { assert(transform); }
-		Transform * transform;
+		Light(Transform transform_) : transform(transform_) { assert(transform); }
+		Transform transform;
 		//NOTE: directional, spot, and hemisphere lights are directed along their -z axis
 
 		enum Type : char {
@@ -117,37 +181,43 @@ struct Scene {
 	};
 
 	//Scenes, of course, may have many of the above objects:
-	std::list< Transform > transforms;
-	std::list< Drawable > drawables;
-	std::list< Camera > cameras;
-	std::list< Light > lights;
+	// (n.b. adding drawables, cameras, or lights moves the existing ones, so hold on to pointers only once a scene is built)
+	Transforms transforms;
+	std::vector< Drawable > drawables;
+	std::vector< Camera > cameras;
+	std::vector< Light > lights;
 
 	//The "draw" function provides a convenient way to pass all the things in a scene to OpenGL:
+	// (the camera must be in this scene; drawables with bounds entirely outside its view are skipped)
 	void draw(Camera const &camera) const;
 
 	//..sometimes, you want to draw with a custom projection matrix and/or light space:
+	// (drawables are skipped if their bounds are entirely outside the [-1,1]^3 clip volume)
 	void draw(glm::mat4 const &world_to_clip, glm::mat4x3 const &world_to_light = glm::mat4x3(1.0f)) const;
 
+	//what the most recent draw() did with the drawables:
+	mutable uint32_t drawn = 0; //sent to OpenGL
+	mutable uint32_t culled = 0; //skipped, since their bounds were entirely outside the view
+
 	//add transforms/objects/cameras from a scene file to this scene:
 	// the 'on_drawable' callback gives your code a chance to look up mesh data and make Drawables:
 	// throws on file format errors
 	void load(std::string const &filename,
-		std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable = nullptr
+		std::function< void(Scene &, Transform, std::string const &) > const &on_drawable = nullptr
 	);
 
 	//this function is called to read extra chunks from the scene file after the main chunks are read:
 	// this is useful if you, e.g., subclassing scene to represent a game level/area
-	virtual void load_extra(std::istream &from, std::vector< char > const &str0, std::vector< Transform * > const &xfh0) { }
+	virtual void load_extra(std::istream &from, std::vector< char > const &str0, std::vector< Transform > const &xfh0) { }
 
 	//empty scene:
 	Scene() = default;
 
 	//load a scene:
-	Scene(std::string const &filename, std::function< void(Scene &, Transform *, std::string const &) > const &on_drawable);
+	Scene(std::string const &filename, std::function< void(Scene &, Transform, std::string const &) > const &on_drawable);
 
-	//copy a scene (with proper pointer fixup):
+	//copy a scene (transform handles are the same in the copy, so no fixup is needed):
 	Scene(Scene const &); //...as a constructor
 	Scene &operator=(Scene const &); //...as scene = scene
-	//... as a set() function that optionally returns the transform->transform mapping:
-	void set(Scene const &, std::unordered_map< Transform const *, Transform * > *transform_map = nullptr);
+	void set(Scene const &); //...as a set() function
 };
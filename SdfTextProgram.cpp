@@ -0,0 +1,60 @@
+#include "SdfTextProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+Load< SdfTextProgram > sdf_text_program(LoadTagEarly);
+
+SdfTextProgram::SdfTextProgram() {
+	//vertex shader is ColorTextureProgram's (from https://learnopengl.com/In-Practice/Text-Rendering), with color moved to a per-vertex attribute;
+	//fragment shader thresholds the distance field, using its screen-space derivative to pick an anti-aliasing width:
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330 core\n"
+		"layout (location = 0) in vec4 vertex;\n"
+		"in vec4 Color;\n"
+		"out vec2 TexCoords;\n"
+		"out vec4 textColor;\n"
+		"uniform mat4 projection;\n"
+		"void main() {\n"
+		"	gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);\n"
+		"	TexCoords = vertex.zw;\n"
+		"	textColor = Color;\n"
+		"}\n"
+		,
+		//fragment shader:
+		"#version 330 core\n"
+		"in vec2 TexCoords;\n"
+		"in vec4 textColor;\n"
+		"out vec4 color;\n"
+		"uniform sampler2D text;\n"
+		"void main() {\n"
+		"	float dist = texture(text, TexCoords).r;\n"
+		"	float width = max(fwidth(dist), 1.0 / 255.0);\n"
+		"	float alpha = smoothstep(0.5 - width, 0.5 + width, dist);\n"
+		"	color = vec4(textColor.rgb, textColor.a * alpha);\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	vertex_vec4 = glGetAttribLocation(program, "vertex");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	projection_mat4 = glGetUniformLocation(program, "projection");
+	GLuint text_sampler2D = glGetUniformLocation(program, "text");
+
+	//set TEX to always refer to texture binding zero:
+	glUseProgram(program); //bind program -- glUniform* calls refer to this program now
+
+	glUniform1i(text_sampler2D, 0); //set TEX to sample from GL_TEXTURE0
+
+	glUseProgram(0); //unbind program -- glUniform* calls refer to ??? now
+}
+
+SdfTextProgram::~SdfTextProgram() {
+	if (program != 0) {
+		glDeleteProgram(program);
+		program = 0;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "GL.hpp"
+#include "Load.hpp"
+
+//Shader program that draws text from a signed distance field glyph atlas (see make_sdf.hpp):
+// edges are re-computed per-pixel from the distance field, so one atlas can be drawn crisply at any scale.
+struct SdfTextProgram {
+	SdfTextProgram();
+	~SdfTextProgram();
+
+	GLuint program = 0;
+	//Attribute (per-vertex variable) locations:
+	GLuint vertex_vec4 = -1U; //xy = position, zw = texcoord
+	GLuint Color_vec4 = -1U;
+	//Uniform (per-invocation variable) locations:
+	GLuint projection_mat4 = -1U;
+	//Textures:
+	//TEXTURE0 - distance field (red channel; 0.5 on the outline, larger inside)
+};
+
+extern Load< SdfTextProgram > sdf_text_program;
@@ -0,0 +1,107 @@
+#include "ShapeCache.hpp"
+
+#include <cassert>
+#include <functional>
+
+ShapeCache::ShapeCache(size_t capacity_) : capacity(capacity_) {
+	assert(capacity > 0);
+	buffer = hb_buffer_create();
+}
+
+ShapeCache::~ShapeCache() {
+	hb_buffer_destroy(buffer);
+	buffer = nullptr;
+}
+
+size_t ShapeCache::hash_key(StringPool::Handle text, uint32_t font_id, uint32_t size) {
+	size_t h = std::hash< uint32_t >{}(text);
+	//boost-style hash_combine:
+	h ^= std::hash< uint32_t >{}(font_id) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash< uint32_t >{}(size) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+ShapeCache::Run const &ShapeCache::get(StringPool::Handle text, hb_font_t *font, uint32_t font_id, uint32_t size) {
+	if (Run const *run = find(text, font_id, size)) return *run;
+
+	Run &run = insert(text, font_id, size);
+	shape(string_pool[text], font, &run);
+	return run;
+}
+
+ShapeCache::Run const *ShapeCache::find(StringPool::Handle text, uint32_t font_id, uint32_t size) {
+	size_t hash = hash_key(text, font_id, size);
+
+	auto range = lookup.equal_range(hash);
+	for (auto l = range.first; l != range.second; ++l) {
+		Entry &entry = *l->second;
+		if (entry.font_id == font_id && entry.size == size && entry.text == text) {
+			hits += 1;
+			//move to front of LRU list (doesn't invalidate iterators):
+			entries.splice(entries.begin(), entries, l->second);
+			return &entry.run;
+		}
+	}
+
+	misses += 1;
+	return nullptr;
+}
+
+ShapeCache::Run &ShapeCache::insert(StringPool::Handle text, uint32_t font_id, uint32_t size) {
+	size_t hash = hash_key(text, font_id, size);
+
+	//make room:
+	while (entries.size() >= capacity) {
+		Entry const &victim = entries.back();
+		auto range = lookup.equal_range(victim.hash);
+		for (auto l = range.first; l != range.second; ++l) {
+			if (&*l->second == &victim) {
+				lookup.erase(l);
+				break;
+			}
+		}
+		entries.pop_back();
+		evictions += 1;
+	}
+
+	entries.emplace_front();
+	Entry &entry = entries.front();
+	entry.text = text;
+	entry.font_id = font_id;
+	entry.size = size;
+	entry.hash = hash;
+	lookup.emplace(hash, entries.begin());
+
+	return entry.run;
+}
+
+void ShapeCache::shape(std::string_view text, hb_font_t *font, Run *run_) {
+	assert(run_);
+	auto &run = *run_;
+
+	// Harfbuzz code based on https://github.com/harfbuzz/harfbuzz-tutorial/blob/master/hello-harfbuzz-freetype.c
+	hb_buffer_clear_contents(buffer);
+	hb_buffer_add_utf8(buffer, text.data(), int(text.size()), 0, int(text.size()));
+	hb_buffer_guess_segment_properties(buffer);
+	hb_shape(font, buffer, NULL, 0);
+
+	uint32_t len = hb_buffer_get_length(buffer);
+	hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(buffer, NULL);
+	hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(buffer, NULL);
+
+	run.clear();
+	run.reserve(len);
+	for (uint32_t i = 0; i < len; ++i) {
+		run.emplace_back(Glyph{
+			infos[i].codepoint,
+			glm::ivec2(positions[i].x_advance, positions[i].y_advance),
+			glm::ivec2(positions[i].x_offset, positions[i].y_offset),
+			infos[i].cluster
+		});
+	}
+}
+
+void ShapeCache::clear() {
+	entries.clear();
+	lookup.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * ShapeCache remembers the output of HarfBuzz shaping (glyph ids and positions)
+ *  for recently-drawn strings, so that text which doesn't change from frame
+ *  to frame is only shaped once.
+ *
+ * Runs are keyed by (text, font, size) and evicted least-recently-used first
+ *  once more than 'capacity' runs are stored. Text is named by its handle in
+ *  string_pool (see StringPool.hpp), so a lookup hashes and compares a few
+ *  integers no matter how long the string is.
+ *
+ */
+
+#include "StringPool.hpp"
+
+#include <hb.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct ShapeCache {
+	ShapeCache(size_t capacity = 64);
+	~ShapeCache();
+
+	//since cache owns a hb_buffer_t, copying is not advised:
+	ShapeCache(ShapeCache const &) = delete;
+	ShapeCache &operator=(ShapeCache const &) = delete;
+
+	struct Glyph {
+		uint32_t index; //glyph index in font
+		glm::ivec2 advance; //cursor movement after this glyph (26.6 fixed point, like hb_glyph_position_t)
+		glm::ivec2 offset; //offset of this glyph from the cursor (26.6 fixed point)
+		uint32_t cluster; //byte offset in the text of the (first) character this glyph came from
+		//style from rich text markup (set by FontManager::shape_rich; shaping leaves the defaults):
+		bool bold = false; //drawn with the bold version of the run's style
+		bool has_color = false; //if false, drawn in the caller's default color
+		glm::u8vec4 color = glm::u8vec4(0xff);
+	};
+	typedef std::vector< Glyph > Run;
+
+	//get the shaped glyphs for pooled string 'text', shaping it with 'font' if it isn't cached:
+	// 'font_id' and 'size' identify the font + size combination for cache lookup;
+	// they must change whenever the output of shaping with 'font' would.
+	// (returned reference is valid until the next call to get() or clear())
+	Run const &get(StringPool::Handle text, hb_font_t *font, uint32_t font_id, uint32_t size);
+
+	//lower-level interface, for runs that come from somewhere other than HarfBuzz (e.g., BakedFont):
+	// find() returns nullptr (and counts a miss) if the run isn't cached;
+	// insert() adds an empty run for the caller to fill (the key must not already be cached).
+	// (returned pointers/references are valid until the next call to get(), insert(), or clear())
+	Run const *find(StringPool::Handle text, uint32_t font_id, uint32_t size);
+	Run &insert(StringPool::Handle text, uint32_t font_id, uint32_t size);
+
+	//shape 'text' with HarfBuzz into 'run' (without caching the result):
+	void shape(std::string_view text, hb_font_t *font, Run *run);
+
+	//drop all cached runs:
+	void clear();
+
+	//counters (never reset):
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+
+	//--- internals ---
+	size_t capacity;
+
+	struct Entry {
+		StringPool::Handle text;
+		uint32_t font_id;
+		uint32_t size;
+		size_t hash;
+		Run run;
+	};
+	//entries, most recently used at the front:
+	std::list< Entry > entries;
+	//hash -> entry (hashes may collide, so lookups compare the full key):
+	std::unordered_multimap< size_t, std::list< Entry >::iterator > lookup;
+
+	hb_buffer_t *buffer = nullptr;
+
+	static size_t hash_key(StringPool::Handle text, uint32_t font_id, uint32_t size);
+};
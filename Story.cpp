@@ -0,0 +1,75 @@
+#include "Story.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <stdexcept>
+
+template< typename T >
+static void view(char const **at, char const *end, char const *magic, Story::Array< T > *array) {
+	view_chunk(at, end, magic, &array->data, &array->count);
+}
+
+Story::Story(std::string const &filename) : file(filename) {
+	char const *at = file.data;
+	char const *end = file.data + file.size;
+
+	Array< Header > headers;
+	view(&at, end, "sty0", &headers);
+	if (headers.size() != 1) {
+		throw std::runtime_error("Story '" + filename + "' should have exactly one header.");
+	}
+	if (headers[0].version != Version) {
+		throw std::runtime_error("Story '" + filename + "' is version " + std::to_string(headers[0].version) + ", but this build reads version " + std::to_string(Version) + "; recompile it with story-compile.");
+	}
+	start_node = headers[0].start_node;
+	start_result = headers[0].start_result;
+
+	view(&at, end, "str0", &string_data);
+	view(&at, end, "sid0", &strings);
+	view(&at, end, "bit0", &bits);
+	view(&at, end, "loc0", &locations);
+	view(&at, end, "nod0", &nodes);
+	view(&at, end, "cnd0", &conditions);
+	view(&at, end, "edg0", &edges);
+
+	//check ids, so that lookups during play never need to:
+	auto check = [&](bool ok, char const *what) {
+		if (!ok) throw std::runtime_error("Story '" + filename + "' has " + what + ".");
+	};
+	for (StringEntry const &entry : strings) {
+		check(entry.begin <= entry.end && entry.end <= string_data.size(), "a string outside its string pool");
+	}
+	for (Bit const &bit : bits) {
+		check(bit.name < strings.size(), "a bad bit name");
+	}
+	check(bits.size() <= MaxBits, "too many bits");
+	for (Location const &location : locations) {
+		check(location.name < strings.size(), "a bad location name");
+	}
+	for (Node const &node : nodes) {
+		check(node.name < strings.size() && node.message < strings.size() && node.left < strings.size() && node.right < strings.size(), "a node with a bad string");
+		check(node.location < locations.size(), "a node with a bad location");
+		check(node.edges[0] <= node.edges[1] && node.edges[1] <= node.edges[2] && node.edges[2] <= edges.size(), "a node with bad edges");
+	}
+	check(!conditions.empty(), "no conditions (condition 0 should always hold)");
+	for (Edge const &edge : edges) {
+		check(edge.condition < conditions.size(), "an edge with a bad condition");
+		check(edge.target < nodes.size(), "an edge with a bad target");
+		check(edge.result < strings.size(), "an edge with a bad result");
+	}
+	check(start_node < nodes.size() && start_result < strings.size(), "a bad start");
+}
+
+uint32_t Story::find_node(std::string_view name) const {
+	for (uint32_t n = 0; n < nodes.size(); ++n) {
+		if (string(nodes[n].name) == name) return n;
+	}
+	return Invalid;
+}
+
+uint32_t Story::find_bit(std::string_view name) const {
+	for (uint32_t b = 0; b < bits.size(); ++b) {
+		if (string(bits[b].name) == name) return b;
+	}
+	return Invalid;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+/*
+ * A Story is the game's plot, compiled into flat arrays indexed by integer ids:
+ *  - nodes: one screen each (location, message, and the left/right choices)
+ *  - edges: what each choice at a node does, in priority order
+ *  - conditions: which state bits an edge needs set (and clear)
+ *  - strings: all of the story's text, in one pool
+ *
+ * Items and flags share one 64-bit mask of state bits, kept with the current
+ *  node in a GameState (GameState.hpp). Choosing a side at a node takes the
+ *  first of that side's edges whose condition holds; taking it sets/clears
+ *  bits and moves to the edge's target. That is a scan of a few contiguous
+ *  edges, with no string compares and no allocation.
+ *
+ * Stories are written as text (see dist/story.txt for the format) and
+ *  compiled by story-compile (StorySource.hpp) into a chunked binary file:
+ *
+ *    sty0: Header
+ *    str0: string bytes (zero-padded to a multiple of 8)
+ *    sid0: StringEntry per string (byte ranges in str0)
+ *    bit0, loc0, nod0, cnd0, edg0: Bit, Location, Node, Condition, Edge arrays
+ *
+ * Loading maps that file and uses the arrays where they sit (every record
+ *  is a multiple of 8 bytes, so each chunk stays aligned); the only work is
+ *  a pass checking that ids are in range.
+ *
+ */
+
+#include "MappedFile.hpp"
+#include "GameState.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+struct Story {
+	//map a compiled story file; throws on error:
+	Story(std::string const &filename);
+
+	Story(Story const &) = delete;
+	Story &operator=(Story const &) = delete;
+
+	static constexpr uint32_t Invalid = ~0u;
+	static constexpr uint32_t MaxBits = 64;
+	static constexpr uint32_t Version = 1;
+
+	enum Side : uint32_t {
+		Left = 0,
+		Right = 1,
+	};
+
+	struct Header {
+		uint32_t version; //Version
+		uint32_t start_node;
+		uint32_t start_result; //string
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Header) == 16, "Header is packed");
+
+	struct StringEntry {
+		uint32_t begin, end; //byte range in str0
+	};
+	static_assert(sizeof(StringEntry) == 8, "StringEntry is packed");
+
+	//items and flags are both state bits (named for tools + error messages):
+	struct Bit {
+		uint32_t name; //string
+		uint32_t is_flag; //0 for items
+	};
+	static_assert(sizeof(Bit) == 8, "Bit is packed");
+
+	struct Location {
+		uint32_t name; //string
+		uint32_t camera; //index of the location's camera in the scene
+	};
+	static_assert(sizeof(Location) == 8, "Location is packed");
+
+	struct Condition {
+		uint64_t require; //bits that must be set
+		uint64_t forbid; //bits that must be clear
+		bool holds(uint64_t bits) const {
+			return (bits & require) == require && (bits & forbid) == 0;
+		}
+	};
+	static_assert(sizeof(Condition) == 16, "Condition is packed");
+
+	enum Action : uint32_t {
+		ActionRecordTime = 1, //remember the time (for "{time}" in results)
+	};
+
+	struct Edge {
+		uint32_t condition; //index into conditions (0 always holds)
+		uint32_t target; //node
+		uint32_t result; //string shown after taking this edge
+		uint32_t actions; //Action bits
+		uint64_t set; //state bits set by taking this edge
+		uint64_t clear; //state bits cleared by taking this edge
+	};
+	static_assert(sizeof(Edge) == 32, "Edge is packed");
+
+	enum NodeFlags : uint32_t {
+		NodeWin = 1, //ending where the player escapes
+	};
+
+	struct Node {
+		uint32_t name; //string
+		uint32_t location;
+		uint32_t message, left, right; //strings
+		uint32_t edges[3]; //edges for side s are [edges[s], edges[s+1])
+		uint32_t flags; //NodeFlags
+		uint32_t reserved; //(keeps Node a multiple of 8 bytes)
+	};
+	static_assert(sizeof(Node) == 40, "Node is packed");
+
+	//read-only view of an array in the mapped file:
+	template< typename T >
+	struct Array {
+		T const *data = nullptr;
+		size_t count = 0;
+		T const &operator[](size_t i) const { return data[i]; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		T const *begin() const { return data; }
+		T const *end() const { return data + count; }
+	};
+
+	Array< char > string_data;
+	Array< StringEntry > strings;
+	Array< Bit > bits;
+	Array< Location > locations;
+	Array< Node > nodes;
+	Array< Condition > conditions;
+	Array< Edge > edges;
+
+	uint32_t start_node = 0;
+	uint32_t start_result = 0;
+
+	//text of string 'id' (points into the mapped file):
+	std::string_view string(uint32_t id) const {
+		StringEntry const &entry = strings[id];
+		return std::string_view(string_data.data + entry.begin, entry.end - entry.begin);
+	}
+
+	//edge taken by choosing 'side' at 'node' with state 'bits' (Invalid if the choice does nothing):
+	uint32_t choose(uint32_t node, Side side, uint64_t bits) const {
+		Node const &n = nodes[node];
+		for (uint32_t e = n.edges[side]; e < n.edges[side+1]; ++e) {
+			if (conditions[edges[e].condition].holds(bits)) return e;
+		}
+		return Invalid;
+	}
+
+	//state bits after taking 'edge':
+	static uint64_t apply(Edge const &edge, uint64_t bits) {
+		return (bits | edge.set) & ~edge.clear;
+	}
+
+	//state at the start of the story:
+	GameState start() const {
+		GameState state;
+		state.node = start_node;
+		state.location = nodes[start_node].location;
+		return state;
+	}
+
+	//edge taken by choosing 'side' in 'state' (Invalid if the choice does nothing):
+	uint32_t choose(GameState const &state, Side side) const {
+		return choose(state.node, side, state.bits);
+	}
+
+	//state after taking 'edge' from 'state':
+	GameState take(GameState const &state, uint32_t edge) const {
+		Edge const &e = edges[edge];
+		GameState next;
+		next.bits = apply(e, state.bits);
+		next.node = e.target;
+		next.location = nodes[e.target].location;
+		return next;
+	}
+
+	//node with no edges at all:
+	bool is_ending(uint32_t node) const {
+		return nodes[node].edges[0] == nodes[node].edges[2];
+	}
+
+	//look up names (linear search; meant for tools, not per-step use); returns Invalid if not found:
+	uint32_t find_node(std::string_view name) const;
+	uint32_t find_bit(std::string_view name) const;
+
+	//--- internals ---
+	MappedFile file;
+};
@@ -0,0 +1,272 @@
+#include "StorySource.hpp"
+
+#include "read_write_chunk.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+//split 'line' into words; "quoted" words may contain spaces and \" or \\ escapes; '#' starts a comment:
+static bool split_words(std::string const &line, std::vector< std::string > *words_) {
+	assert(words_);
+	auto &words = *words_;
+	words.clear();
+
+	for (size_t i = 0; i < line.size(); /* later */) {
+		char c = line[i];
+		if (c == ' ' || c == '\t' || c == '\r') {
+			++i;
+		} else if (c == '#') {
+			break;
+		} else if (c == '"') {
+			std::string word;
+			++i;
+			while (true) {
+				if (i >= line.size()) return false; //unterminated quote
+				if (line[i] == '"') {
+					++i;
+					break;
+				}
+				if (line[i] == '\\' && i + 1 < line.size()) ++i;
+				word += line[i];
+				++i;
+			}
+			words.emplace_back(word);
+		} else {
+			size_t begin = i;
+			while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r') ++i;
+			words.emplace_back(line.substr(begin, i - begin));
+		}
+	}
+	return true;
+}
+
+StorySource::StorySource(std::string const &filename) {
+	std::ifstream file(filename, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open story '" + filename + "'.");
+	}
+
+	//names -> ids while parsing:
+	std::unordered_map< std::string, uint32_t > text_ids, bit_ids, location_ids, node_ids;
+
+	//edges are collected in file order and sorted into per-node ranges at the end:
+	struct ParsedEdge {
+		uint32_t from; //node
+		Story::Side side;
+		std::string target; //node name (may not be declared yet)
+		uint32_t line;
+		Story::Edge edge;
+	};
+	std::vector< ParsedEdge > parsed_edges;
+	std::string start_name;
+	uint32_t start_line = 0;
+
+	conditions.emplace_back(Story::Condition{ 0, 0 }); //(condition 0 always holds)
+
+	uint32_t line_number = 0;
+	std::string line;
+	std::vector< std::string > words;
+	while (std::getline(file, line)) {
+		line_number += 1;
+		auto error = [&](std::string const &what) {
+			return std::runtime_error("Story '" + filename + "' line " + std::to_string(line_number) + ": " + what);
+		};
+		auto lookup = [&](std::unordered_map< std::string, uint32_t > const &ids, std::string const &name, char const *kind) {
+			auto f = ids.find(name);
+			if (f == ids.end()) throw error("unknown " + std::string(kind) + " '" + name + "'.");
+			return f->second;
+		};
+		auto declare = [&](std::unordered_map< std::string, uint32_t > &ids, std::string const &name, uint32_t id, char const *kind) {
+			if (!ids.emplace(name, id).second) throw error(std::string(kind) + " '" + name + "' declared twice.");
+		};
+
+		if (!split_words(line, &words)) throw error("unterminated quote.");
+		if (words.empty()) continue;
+
+		std::string const &what = words[0];
+		if (what == "item" || what == "flag") {
+			if (words.size() != 2) throw error("expecting '" + what + " <name>'.");
+			if (bits.size() >= Story::MaxBits) throw error("more than " + std::to_string(Story::MaxBits) + " items + flags.");
+			declare(bit_ids, words[1], uint32_t(bits.size()), "bit");
+			bits.emplace_back(Story::Bit{ add_string(words[1]), (what == "flag" ? 1u : 0u) });
+		} else if (what == "location") {
+			if (words.size() != 3) throw error("expecting 'location <name> <camera>'.");
+			declare(location_ids, words[1], uint32_t(locations.size()), "location");
+			uint32_t camera;
+			try {
+				size_t used = 0;
+				unsigned long value = std::stoul(words[2], &used);
+				if (used != words[2].size() || words[2][0] == '-' || value > 0xffffffffUL) throw std::out_of_range("camera");
+				camera = uint32_t(value);
+			} catch (std::logic_error &) { //(std::invalid_argument or std::out_of_range)
+				throw error("bad camera index '" + words[2] + "'.");
+			}
+			locations.emplace_back(Story::Location{ add_string(words[1]), camera });
+		} else if (what == "text") {
+			if (words.size() != 3) throw error("expecting 'text <NAME> \"<string>\"'.");
+			declare(text_ids, words[1], add_string(words[2]), "text");
+		} else if (what == "node") {
+			if (words.size() != 6 && !(words.size() == 7 && words[6] == "win")) {
+				throw error("expecting 'node <name> <location> <MESSAGE> <LEFT> <RIGHT> [win]'.");
+			}
+			Story::Node node;
+			node.location = lookup(location_ids, words[2], "location");
+			node.message = lookup(text_ids, words[3], "text");
+			node.left = lookup(text_ids, words[4], "text");
+			node.right = lookup(text_ids, words[5], "text");
+			node.flags = (words.size() == 7 ? Story::NodeWin : 0u);
+			node.reserved = 0;
+			declare(node_ids, words[1], uint32_t(nodes.size()), "node");
+			node.name = add_string(words[1]);
+			nodes.emplace_back(node);
+		} else if (what == "edge") {
+			if (words.size() < 5 || (words[2] != "left" && words[2] != "right")) {
+				throw error("expecting 'edge <node> <left|right> <target> <RESULT> [if ...] [do ...]'.");
+			}
+			ParsedEdge parsed;
+			parsed.from = lookup(node_ids, words[1], "node");
+			parsed.side = (words[2] == "left" ? Story::Left : Story::Right);
+			parsed.target = words[3];
+			parsed.line = line_number;
+			parsed.edge.result = lookup(text_ids, words[4], "text");
+			parsed.edge.actions = 0;
+			parsed.edge.set = 0;
+			parsed.edge.clear = 0;
+
+			Story::Condition condition{ 0, 0 };
+			enum { None, If, Do } mode = None;
+			for (size_t w = 5; w < words.size(); ++w) {
+				std::string const &word = words[w];
+				if (word == "if" && mode == None) {
+					mode = If;
+				} else if (word == "do" && mode != Do) {
+					mode = Do;
+				} else if (mode == If) {
+					bool negate = (word[0] == '!');
+					uint64_t bit = uint64_t(1) << lookup(bit_ids, word.substr(negate ? 1 : 0), "bit");
+					(negate ? condition.forbid : condition.require) |= bit;
+				} else if (mode == Do && word == "record_time") {
+					parsed.edge.actions |= Story::ActionRecordTime;
+				} else if (mode == Do && (word[0] == '+' || word[0] == '-')) {
+					uint64_t bit = uint64_t(1) << lookup(bit_ids, word.substr(1), "bit");
+					(word[0] == '+' ? parsed.edge.set : parsed.edge.clear) |= bit;
+				} else {
+					throw error("unexpected '" + word + "' in edge.");
+				}
+			}
+			if (condition.require & condition.forbid) throw error("edge requires a bit to be both set and clear.");
+
+			//share identical conditions:
+			parsed.edge.condition = uint32_t(conditions.size());
+			for (uint32_t c = 0; c < conditions.size(); ++c) {
+				if (conditions[c].require == condition.require && conditions[c].forbid == condition.forbid) {
+					parsed.edge.condition = c;
+					break;
+				}
+			}
+			if (parsed.edge.condition == conditions.size()) conditions.emplace_back(condition);
+
+			parsed_edges.emplace_back(parsed);
+		} else if (what == "start") {
+			if (words.size() != 3) throw error("expecting 'start <node> <RESULT>'.");
+			if (start_line != 0) throw error("story has two starts.");
+			start_name = words[1];
+			start_line = line_number;
+			start_result = lookup(text_ids, words[2], "text");
+		} else {
+			throw error("unknown declaration '" + what + "'.");
+		}
+	}
+
+	//resolve targets now that all nodes are known:
+	for (auto &parsed : parsed_edges) {
+		auto f = node_ids.find(parsed.target);
+		if (f == node_ids.end()) {
+			throw std::runtime_error("Story '" + filename + "' line " + std::to_string(parsed.line) + ": unknown node '" + parsed.target + "'.");
+		}
+		parsed.edge.target = f->second;
+	}
+	if (start_line == 0) {
+		throw std::runtime_error("Story '" + filename + "' has no start.");
+	}
+	{
+		auto f = node_ids.find(start_name);
+		if (f == node_ids.end()) {
+			throw std::runtime_error("Story '" + filename + "' line " + std::to_string(start_line) + ": unknown node '" + start_name + "'.");
+		}
+		start_node = f->second;
+	}
+
+	//group edges by (node, side), keeping file order (= priority) within each group:
+	std::stable_sort(parsed_edges.begin(), parsed_edges.end(), [](ParsedEdge const &a, ParsedEdge const &b) {
+		if (a.from != b.from) return a.from < b.from;
+		return a.side < b.side;
+	});
+	edges.reserve(parsed_edges.size());
+	auto next = parsed_edges.begin();
+	for (uint32_t n = 0; n < nodes.size(); ++n) {
+		for (uint32_t s = 0; s < 2; ++s) {
+			nodes[n].edges[s] = uint32_t(edges.size());
+			while (next != parsed_edges.end() && next->from == n && next->side == Story::Side(s)) {
+				edges.emplace_back(next->edge);
+				++next;
+			}
+		}
+		nodes[n].edges[2] = uint32_t(edges.size());
+	}
+	assert(next == parsed_edges.end());
+}
+
+uint32_t StorySource::add_string(std::string_view str) {
+	auto f = string_ids.find(std::string(str));
+	if (f != string_ids.end()) return f->second;
+
+	Story::StringEntry entry;
+	entry.begin = uint32_t(string_data.size());
+	string_data.insert(string_data.end(), str.begin(), str.end());
+	entry.end = uint32_t(string_data.size());
+	strings.emplace_back(entry);
+
+	uint32_t id = uint32_t(strings.size() - 1);
+	string_ids.emplace(std::string(str), id);
+	return id;
+}
+
+void StorySource::save(std::string const &filename) const {
+	//write to a temporary file and rename it into place, so a running game that has mapped the old file
+	// (and is watching for changes to reload it) never sees a half-written one:
+	std::string temp = filename + ".tmp";
+	std::ofstream file(temp, std::ios::binary);
+
+	Story::Header header;
+	header.version = Story::Version;
+	header.start_node = start_node;
+	header.start_result = start_result;
+	header.reserved = 0;
+	write_chunk("sty0", std::vector< Story::Header >{ header }, &file);
+
+	//pad the string pool so that the chunks after it stay 8-byte aligned:
+	std::vector< char > padded = string_data;
+	padded.resize((padded.size() + 7) / 8 * 8, '\0');
+	write_chunk("str0", padded, &file);
+
+	write_chunk("sid0", strings, &file);
+	write_chunk("bit0", bits, &file);
+	write_chunk("loc0", locations, &file);
+	write_chunk("nod0", nodes, &file);
+	write_chunk("cnd0", conditions, &file);
+	write_chunk("edg0", edges, &file);
+
+	file.close();
+	if (!file) {
+		throw std::runtime_error("Failed to write story '" + temp + "'.");
+	}
+	std::error_code ec;
+	std::filesystem::rename(temp, filename, ec);
+	if (ec) {
+		throw std::runtime_error("Failed to replace story '" + filename + "': " + ec.message());
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+/*
+ * StorySource reads a story's text form (see dist/story.txt for the format)
+ *  into the same arrays a Story maps (see Story.hpp), and writes them out as
+ *  a compiled story file.
+ *
+ * Tools use this (see story-compile.cpp), as does the game when dist/story.txt
+ *  is edited while it runs (see PlayMode::reload_story); otherwise the game
+ *  only maps the compiled file.
+ *
+ */
+
+#include "Story.hpp"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct StorySource {
+	//parse a story's text form; throws on error (with the file and line):
+	StorySource(std::string const &filename);
+
+	//write the compiled form (for Story to map):
+	void save(std::string const &filename) const;
+
+	//identical strings share one entry:
+	uint32_t add_string(std::string_view str);
+
+	std::vector< char > string_data;
+	std::vector< Story::StringEntry > strings;
+	std::vector< Story::Bit > bits;
+	std::vector< Story::Location > locations;
+	std::vector< Story::Node > nodes;
+	std::vector< Story::Condition > conditions;
+	std::vector< Story::Edge > edges;
+
+	uint32_t start_node = 0;
+	uint32_t start_result = 0;
+
+	//--- internals ---
+	std::unordered_map< std::string, uint32_t > string_ids;
+};
@@ -0,0 +1,43 @@
+#include "StringPool.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+StringPool string_pool;
+
+StringPool::Handle StringPool::intern(std::string_view str) {
+	auto f = lookup.find(str);
+	if (f != lookup.end()) return f->second;
+
+	if (entries.size() >= Invalid) {
+		throw std::runtime_error("StringPool is out of handles.");
+	}
+
+	//copy the text into a block (so the entry doesn't depend on the caller's storage):
+	char *stored;
+	if (str.size() > BlockSize) {
+		//(too long to share a block; give it one of its own)
+		blocks.emplace_back(new char[str.size()]);
+		stored = blocks.back().get();
+		block_used = BlockSize; //(so the next string starts a fresh block)
+	} else {
+		if (blocks.empty() || block_used + str.size() > BlockSize) {
+			blocks.emplace_back(new char[BlockSize]);
+			block_used = 0;
+		}
+		stored = blocks.back().get() + block_used;
+		block_used += str.size();
+	}
+	if (!str.empty()) std::memcpy(stored, str.data(), str.size());
+
+	Handle handle = Handle(entries.size());
+	entries.emplace_back(stored, str.size());
+	lookup.emplace(entries.back(), handle);
+	return handle;
+}
+
+StringPool::Handle StringPool::find(std::string_view str) const {
+	auto f = lookup.find(str);
+	if (f == lookup.end()) return Invalid;
+	return f->second;
+}
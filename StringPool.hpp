@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+ * StringPool interns immutable strings: each distinct text is stored once
+ *  and named by a 32-bit handle. Interning the same text again returns the
+ *  same handle, so comparing strings is comparing handles, passing one
+ *  around copies four bytes, and hashing one is hashing an integer (which
+ *  is what the text caches in ShapeCache.hpp and TextLayout.hpp key on).
+ *
+ * Text is stored in fixed blocks that never move, so views returned by
+ *  operator[] stay valid for the life of the pool. Nothing is ever removed.
+ *
+ * 'string_pool' is the process-wide pool that drawn text is interned in
+ *  (not thread-safe; intern from the main thread).
+ *
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct StringPool {
+	typedef uint32_t Handle;
+	static constexpr Handle Invalid = ~0u;
+
+	StringPool() = default;
+	StringPool(StringPool const &) = delete;
+	StringPool &operator=(StringPool const &) = delete;
+
+	//handle for 'str', adding it to the pool if it is new:
+	Handle intern(std::string_view str);
+
+	//handle for 'str' if it is already in the pool (Invalid otherwise):
+	Handle find(std::string_view str) const;
+
+	//text of 'handle':
+	std::string_view operator[](Handle handle) const {
+		return entries[handle];
+	}
+
+	//number of strings in the pool:
+	uint32_t size() const {
+		return uint32_t(entries.size());
+	}
+
+	//--- internals ---
+	static constexpr size_t BlockSize = 16384; //(longer strings get a block of their own)
+	std::vector< std::unique_ptr< char[] > > blocks;
+	size_t block_used = BlockSize; //bytes used in blocks.back()
+
+	std::vector< std::string_view > entries; //views into blocks
+	std::unordered_map< std::string_view, Handle > lookup; //(keys are views into blocks too)
+};
+
+extern StringPool string_pool;
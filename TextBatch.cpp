@@ -0,0 +1,106 @@
+#include "TextBatch.hpp"
+
+#include "SdfTextProgram.hpp"
+#include "gl_errors.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+TextBatch::TextBatch() {
+	glGenBuffers(1, &vertex_buffer);
+
+	glGenVertexArrays(1, &vertex_buffer_for_sdf_text_program);
+	glBindVertexArray(vertex_buffer_for_sdf_text_program);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+	//position and texcoord travel together in one vec4 attribute:
+	glVertexAttribPointer(
+		sdf_text_program->vertex_vec4, //attribute
+		4, //size
+		GL_FLOAT, //type
+		GL_FALSE, //normalized
+		sizeof(Vertex), //stride
+		(GLbyte *)0 + offsetof(Vertex, Position) //offset
+	);
+	glEnableVertexAttribArray(sdf_text_program->vertex_vec4);
+
+	glVertexAttribPointer(
+		sdf_text_program->Color_vec4, //attribute
+		4, //size
+		GL_UNSIGNED_BYTE, //type
+		GL_TRUE, //normalized
+		sizeof(Vertex), //stride
+		(GLbyte *)0 + offsetof(Vertex, Color) //offset
+	);
+	glEnableVertexAttribArray(sdf_text_program->Color_vec4);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	GL_ERRORS();
+}
+
+TextBatch::~TextBatch() {
+	if (vertex_buffer_for_sdf_text_program != 0) {
+		glDeleteVertexArrays(1, &vertex_buffer_for_sdf_text_program);
+		vertex_buffer_for_sdf_text_program = 0;
+	}
+	if (vertex_buffer != 0) {
+		glDeleteBuffers(1, &vertex_buffer);
+		vertex_buffer = 0;
+	}
+}
+
+void TextBatch::clear() {
+	vertices.clear();
+	stats = Stats();
+}
+
+void TextBatch::add_quad(glm::vec2 const &min, glm::vec2 const &max, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color) {
+	//two triangles, top edge at max.y (which shows uv_min.y):
+	vertices.emplace_back(glm::vec2(min.x, max.y), glm::vec2(uv_min.x, uv_min.y), color);
+	vertices.emplace_back(glm::vec2(min.x, min.y), glm::vec2(uv_min.x, uv_max.y), color);
+	vertices.emplace_back(glm::vec2(max.x, min.y), glm::vec2(uv_max.x, uv_max.y), color);
+
+	vertices.emplace_back(glm::vec2(min.x, max.y), glm::vec2(uv_min.x, uv_min.y), color);
+	vertices.emplace_back(glm::vec2(max.x, min.y), glm::vec2(uv_max.x, uv_max.y), color);
+	vertices.emplace_back(glm::vec2(max.x, max.y), glm::vec2(uv_max.x, uv_min.y), color);
+
+	stats.glyphs += 1;
+}
+
+void TextBatch::draw(glm::uvec2 const &drawable_size, GLuint texture) {
+	if (vertices.empty()) return;
+
+	//upload vertices to vertex_buffer:
+	size_t bytes = vertices.size() * sizeof(Vertex);
+	while (vertex_buffer_capacity < bytes) {
+		vertex_buffer_capacity = (vertex_buffer_capacity == 0 ? 16384 : 2 * vertex_buffer_capacity);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, vertex_buffer_capacity, NULL, GL_STREAM_DRAW); //orphan old storage
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, vertices.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	stats.bytes_uploaded += bytes;
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glUseProgram(sdf_text_program->program);
+	glm::mat4 projection = glm::ortho(0.0f, float(drawable_size.x), 0.0f, float(drawable_size.y));
+	glUniformMatrix4fv(sdf_text_program->projection_mat4, 1, GL_FALSE, glm::value_ptr(projection));
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindVertexArray(vertex_buffer_for_sdf_text_program);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+	stats.draws += 1;
+
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+	glDisable(GL_BLEND);
+
+	GL_ERRORS();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+/*
+ * A TextBatch collects glyph quads from any number of strings into one CPU-side
+ *  vertex stream, then uploads and draws them all with a single draw call.
+ *
+ * Every quad in a batch samples the same texture (i.e., a GlyphAtlas of signed
+ *  distance fields, drawn with SdfTextProgram), so a frame's worth of text
+ *  costs one buffer upload and one glDrawArrays.
+ *
+ * Usage:
+ *   batch.clear(); //start of frame
+ *   batch.add_quad(...); //for every glyph (each with its own color)
+ *   batch.draw(drawable_size, atlas.get_texture()); //once
+ *
+ */
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstddef>
+
+struct TextBatch {
+	TextBatch();
+	~TextBatch();
+
+	//since batch owns GL objects, copying is not advised:
+	TextBatch(TextBatch const &) = delete;
+	TextBatch &operator=(TextBatch const &) = delete;
+
+	//Vertex layout matches SdfTextProgram's 'vertex' (xy = position, zw = texcoord) and 'Color' attributes:
+	struct Vertex {
+		Vertex(glm::vec2 const &Position_, glm::vec2 const &TexCoord_, glm::u8vec4 const &Color_) : Position(Position_), TexCoord(TexCoord_), Color(Color_) { }
+		glm::vec2 Position;
+		glm::vec2 TexCoord;
+		glm::u8vec4 Color;
+	};
+	static_assert(sizeof(Vertex) == 4*2 + 4*2 + 4, "Vertex is packed.");
+
+	//discard all queued quads (call at the start of each frame):
+	void clear();
+
+	//queue a quad covering [min,max] (in pixels, lower-left origin) showing texture rectangle [uv_min,uv_max] in 'color':
+	// (n.b. uv_min is the texture coordinate at the *upper* left, to match GlyphAtlas)
+	void add_quad(glm::vec2 const &min, glm::vec2 const &max, glm::vec2 const &uv_min, glm::vec2 const &uv_max, glm::u8vec4 const &color);
+
+	//upload and draw all queued quads in one call:
+	void draw(glm::uvec2 const &drawable_size, GLuint texture);
+
+	//Counters for the most recent frame (reset by clear()):
+	struct Stats {
+		uint32_t glyphs = 0; //quads queued
+		uint32_t draws = 0; //draw calls issued
+		size_t bytes_uploaded = 0; //vertex bytes sent to the GPU
+	};
+	Stats stats;
+
+	//--- internals ---
+	std::vector< Vertex > vertices;
+
+	//vertex_buffer is created once and re-used every frame; it is "orphaned" before each upload
+	// (re-specified with no data) so the driver can hand back fresh storage instead of waiting
+	// for the previous frame's draw to finish reading the old contents:
+	GLuint vertex_buffer = 0;
+	GLuint vertex_buffer_for_sdf_text_program = 0;
+	size_t vertex_buffer_capacity = 0; //in bytes; grows (by doubling) but never shrinks
+};
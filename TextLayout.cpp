@@ -0,0 +1,175 @@
+#include "TextLayout.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+
+TextLayout::TextLayout(size_t capacity_) : capacity(capacity_) {
+	assert(capacity >= 2 && "need room for both the unwrapped and wrapped layouts of a string");
+}
+
+void TextLayout::set_metrics(float ascender_, float descender_, float line_height_) {
+	ascender = ascender_;
+	descender = descender_;
+	line_height = line_height_;
+	clear();
+}
+
+size_t TextLayout::hash_key(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align) {
+	size_t h = std::hash< uint32_t >{}(text);
+	//boost-style hash_combine:
+	h ^= std::hash< uint32_t >{}(font_id) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash< uint32_t >{}(size) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash< uint32_t >{}(width) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= std::hash< uint32_t >{}(uint32_t(align)) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+TextLayout::Result const &TextLayout::get(StringPool::Handle text, ShapeCache::Run const &run, uint32_t font_id, uint32_t size, float max_width, Align align) {
+	uint32_t width = (max_width > 0.0f ? std::max(1u, uint32_t(std::floor(max_width))) : 0u);
+
+	if (Entry *entry = find(text, font_id, size, width, align)) {
+		hits += 1;
+		return entry->result;
+	}
+
+	//if the string fits on one line, its unwrapped layout works for this width too:
+	if (width != 0) {
+		Entry *natural = find(text, font_id, size, 0, align);
+		if (natural) {
+			hits += 1;
+		} else {
+			misses += 1;
+			natural = &insert(text, font_id, size, 0, align);
+			lay_out(string_pool[text], run, 0.0f, align, &natural->result);
+		}
+		if (natural->result.max.x - natural->result.min.x <= float(width)) {
+			return natural->result;
+		}
+	}
+
+	misses += 1;
+	Entry &entry = insert(text, font_id, size, width, align);
+	lay_out(string_pool[text], run, float(width), align, &entry.result);
+	return entry.result;
+}
+
+void TextLayout::lay_out(std::string_view text, ShapeCache::Run const &run, float max_width, Align align, Result *result_) const {
+	assert(result_);
+	auto &result = *result_;
+	result.glyphs.clear();
+
+	auto is_space = [&](size_t i) {
+		uint32_t c = run[i].cluster;
+		return c < text.size() && text[c] == ' ';
+	};
+
+	//pen x of each glyph if everything were on one line:
+	std::vector< float > x(run.size() + 1);
+	x[0] = 0.0f;
+	for (size_t i = 0; i < run.size(); ++i) {
+		x[i+1] = x[i] + run[i].advance.x / 64.0f;
+	}
+
+	//greedy line breaking at spaces; lines are [begin, end) ranges of glyphs:
+	std::vector< std::pair< size_t, size_t > > lines;
+	{
+		size_t begin = 0;
+		size_t last_space = run.size(); //(run.size() means "no space on this line yet")
+		for (size_t i = 0; i < run.size(); ++i) {
+			if (is_space(i)) {
+				if (i > begin) last_space = i;
+				continue;
+			}
+			if (max_width > 0.0f && x[i+1] - x[begin] > max_width && last_space != run.size()) {
+				lines.emplace_back(begin, last_space);
+				begin = last_space + 1;
+				while (begin < i && is_space(begin)) ++begin;
+				last_space = run.size();
+			}
+		}
+		lines.emplace_back(begin, run.size());
+	}
+
+	//line widths, not counting trailing spaces:
+	std::vector< float > widths;
+	widths.reserve(lines.size());
+	float block_width = 0.0f;
+	for (auto &line : lines) {
+		while (line.second > line.first && is_space(line.second - 1)) --line.second;
+		widths.emplace_back(x[line.second] - x[line.first]);
+		block_width = std::max(block_width, widths.back());
+	}
+
+	//place glyphs, aligning each line within the widest one:
+	result.glyphs.reserve(run.size());
+	for (size_t l = 0; l < lines.size(); ++l) {
+		float shift = 0.0f;
+		if (align == AlignCenter) shift = 0.5f * (block_width - widths[l]);
+		else if (align == AlignRight) shift = block_width - widths[l];
+		float baseline = -float(l) * line_height;
+		for (size_t i = lines[l].first; i < lines[l].second; ++i) {
+			result.glyphs.emplace_back(Glyph{
+				run[i].index,
+				glm::vec2(shift + x[i] - x[lines[l].first], baseline) + glm::vec2(run[i].offset) / 64.0f,
+				run[i].cluster,
+				run[i].bold,
+				run[i].has_color,
+				run[i].color
+			});
+		}
+	}
+
+	result.lines = uint32_t(lines.size());
+	result.min = glm::vec2(0.0f, -float(lines.size() - 1) * line_height + descender);
+	result.max = glm::vec2(block_width, ascender);
+}
+
+void TextLayout::clear() {
+	entries.clear();
+	lookup.clear();
+}
+
+TextLayout::Entry *TextLayout::find(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align) {
+	size_t hash = hash_key(text, font_id, size, width, align);
+	auto range = lookup.equal_range(hash);
+	for (auto l = range.first; l != range.second; ++l) {
+		Entry &entry = *l->second;
+		if (entry.font_id == font_id && entry.size == size && entry.width == width && entry.align == align && entry.text == text) {
+			//move to front of LRU list (doesn't invalidate iterators):
+			entries.splice(entries.begin(), entries, l->second);
+			return &entry;
+		}
+	}
+	return nullptr;
+}
+
+TextLayout::Entry &TextLayout::insert(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align) {
+	size_t hash = hash_key(text, font_id, size, width, align);
+
+	//make room:
+	while (entries.size() >= capacity) {
+		Entry const &victim = entries.back();
+		auto range = lookup.equal_range(victim.hash);
+		for (auto l = range.first; l != range.second; ++l) {
+			if (&*l->second == &victim) {
+				lookup.erase(l);
+				break;
+			}
+		}
+		entries.pop_back();
+		evictions += 1;
+	}
+
+	entries.emplace_front();
+	Entry &entry = entries.front();
+	entry.text = text;
+	entry.font_id = font_id;
+	entry.size = size;
+	entry.width = width;
+	entry.align = align;
+	entry.hash = hash;
+	lookup.emplace(hash, entries.begin());
+	return entry;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+/*
+ * TextLayout turns a shaped run (see ShapeCache.hpp) into positioned lines:
+ *  it breaks lines at spaces so that no line is wider than a maximum width
+ *  (a single word wider than that gets a line to itself), aligns the lines
+ *  against each other, and measures the bounds of the result.
+ *
+ * Layouts are in the units the run was shaped in (pixels at the shaping
+ *  size), with the first line's baseline starting at (0,0) and later lines
+ *  below it (y is up, as in the rest of the text code).
+ *
+ * Results are cached by (text, font, size, width, alignment), least-recently
+ *  used evicted first; text is named by its string_pool handle (see
+ *  StringPool.hpp), so keys are all integers. A string that fits on one line
+ *  is laid out the same way at any width it fits in, so resizing only
+ *  re-lays-out strings that actually wrap.
+ *
+ * Layouts hold glyph indices and pen positions rather than finished quads,
+ *  so they stay valid when the glyph atlas is cleared; the caller turns them
+ *  into quads with the atlas's current metrics.
+ *
+ */
+
+#include "ShapeCache.hpp"
+#include "StringPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <list>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct TextLayout {
+	TextLayout(size_t capacity = 64);
+
+	//set the font's vertical metrics (in pixels at the shaping size; descender is negative):
+	// (clears the cache, since every layout depends on them)
+	void set_metrics(float ascender, float descender, float line_height);
+
+	enum Align : uint8_t {
+		AlignLeft,
+		AlignCenter,
+		AlignRight,
+	};
+
+	struct Glyph {
+		uint32_t index; //glyph index in font
+		glm::vec2 pen; //pen position for this glyph (including any offset from shaping)
+		uint32_t cluster; //byte offset in the text this glyph came from (as in ShapeCache::Glyph)
+		bool bold; //style from rich text markup (as in ShapeCache::Glyph)
+		bool has_color;
+		glm::u8vec4 color;
+	};
+
+	struct Result {
+		std::vector< Glyph > glyphs; //(spaces at line breaks are dropped)
+		uint32_t lines = 0;
+		//box around all lines, from the ascender of the first line to the descender of the last:
+		glm::vec2 min = glm::vec2(0.0f);
+		glm::vec2 max = glm::vec2(0.0f);
+	};
+
+	//lay out 'run' (the shaped version of pooled string 'text' with the font + size given by 'font_id' and 'size')
+	// with lines no wider than 'max_width' (<= 0 for no limit):
+	// (returned reference is valid until the next call to get() or clear())
+	Result const &get(StringPool::Handle text, ShapeCache::Run const &run, uint32_t font_id, uint32_t size, float max_width, Align align = AlignLeft);
+
+	//lay out without caching:
+	void lay_out(std::string_view text, ShapeCache::Run const &run, float max_width, Align align, Result *result) const;
+
+	//drop all cached layouts:
+	void clear();
+
+	//counters (never reset):
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+
+	//--- internals ---
+	float ascender = 0.0f, descender = 0.0f, line_height = 0.0f;
+	size_t capacity;
+
+	struct Entry {
+		StringPool::Handle text;
+		uint32_t font_id;
+		uint32_t size;
+		uint32_t width; //max_width rounded down to whole pixels, or 0 for no limit
+		Align align;
+		size_t hash;
+		Result result;
+	};
+	//entries, most recently used at the front:
+	std::list< Entry > entries;
+	//hash -> entry (hashes may collide, so lookups compare the full key):
+	std::unordered_multimap< size_t, std::list< Entry >::iterator > lookup;
+
+	Entry *find(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align);
+	Entry &insert(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align);
+
+	static size_t hash_key(StringPool::Handle text, uint32_t font_id, uint32_t size, uint32_t width, Align align);
+};
@@ -0,0 +1,79 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(uint32_t threads) {
+	if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t t = 1; t < threads; ++t) {
+		workers.emplace_back(&WorkerPool::work, this, t);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void WorkerPool::work(uint32_t thread) {
+	uint64_t seen = 0;
+	while (true) {
+		std::function< void(uint32_t) > const *to_run;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			wake.wait(lock, [&](){ return quit || job_generation != seen; });
+			if (quit) return;
+			seen = job_generation;
+			to_run = job;
+		}
+
+		(*to_run)(thread);
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			running -= 1;
+			if (running == 0) done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::run(std::function< void(uint32_t) > const &job_) {
+	if (workers.empty()) {
+		job_(0);
+		return;
+	}
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		job = &job_;
+		running = uint32_t(workers.size());
+		job_generation += 1;
+	}
+	wake.notify_all();
+
+	job_(0);
+
+	std::unique_lock< std::mutex > lock(mutex);
+	done.wait(lock, [&](){ return running == 0; });
+	job = nullptr;
+}
+
+void WorkerPool::barrier() {
+	if (workers.empty()) return;
+	uint32_t generation = barrier_generation.load(std::memory_order_acquire);
+	if (barrier_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == size()) {
+		//last one here: reset for the next barrier and release everyone:
+		// (the acq_rel increments mean this thread has seen every other thread's work, and the release passes it on)
+		barrier_waiting.store(0, std::memory_order_relaxed);
+		barrier_generation.fetch_add(1, std::memory_order_release);
+	} else {
+		while (barrier_generation.load(std::memory_order_acquire) == generation) {
+			std::this_thread::yield();
+		}
+	}
+}
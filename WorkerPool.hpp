@@ -0,0 +1,57 @@
+#pragma once
+
+/*
+ * WorkerPool keeps a few threads around to split per-frame work across cores
+ *  (e.g., Scene's world-matrix updates), without starting threads every frame.
+ *
+ * run(job) calls job(thread) once on each thread -- the calling thread is
+ *  thread 0 -- and returns when every call has returned. Inside a job,
+ *  barrier() waits until all threads reach it, which lets a job work in
+ *  phases (all of phase N finishes before any of phase N+1 starts).
+ *
+ * Idle workers sleep; threads waiting at a barrier spin (yielding), since
+ *  phases are expected to be short.
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkerPool {
+	//'threads' includes the calling thread; 0 means one per hardware thread:
+	explicit WorkerPool(uint32_t threads = 0);
+	~WorkerPool();
+
+	WorkerPool(WorkerPool const &) = delete;
+	WorkerPool &operator=(WorkerPool const &) = delete;
+
+	uint32_t size() const { return uint32_t(workers.size()) + 1; }
+
+	//call job(thread) for every thread in [0, size()) and wait for them all:
+	// (not re-entrant: don't call run() from inside a job, or from two threads at once)
+	void run(std::function< void(uint32_t) > const &job);
+
+	//(only from inside a job) wait until every thread has reached this barrier:
+	void barrier();
+
+	//--- internals ---
+	std::vector< std::thread > workers;
+
+	std::mutex mutex;
+	std::condition_variable wake; //workers wait here for a job (or quit)
+	std::condition_variable done; //run() waits here for workers to finish
+	std::function< void(uint32_t) > const *job = nullptr;
+	uint64_t job_generation = 0; //bumped for each run()
+	uint32_t running = 0; //workers still in the current job
+	bool quit = false;
+
+	std::atomic< uint32_t > barrier_waiting{0};
+	std::atomic< uint32_t > barrier_generation{0};
+
+	void work(uint32_t thread);
+};
@@ -0,0 +1,200 @@
+//Offline font baker: rasterizes a font's printable ASCII (plus a few
+// typographic extras) to signed distance fields, packs them into an atlas,
+// and measures advances, ligatures, and pair kerning with HarfBuzz, then
+// writes the lot as a BakedFont file for the game to load at startup.
+//
+// Runs without a window or GL context: GlyphAtlas::get_texture() is never called.
+//
+// usage: bake-font <font.ttf> <out.atlas> [glyph_size] [spread]
+
+#include "BakedFont.hpp"
+#include "GlyphAtlas.hpp"
+#include "make_sdf.hpp"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <hb.h>
+#include <hb-ft.h>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+//encode a codepoint as UTF-8:
+static std::string utf8(uint32_t cp) {
+	std::string ret;
+	if (cp < 0x80) {
+		ret += char(cp);
+	} else if (cp < 0x800) {
+		ret += char(0xc0 | (cp >> 6));
+		ret += char(0x80 | (cp & 0x3f));
+	} else if (cp < 0x10000) {
+		ret += char(0xe0 | (cp >> 12));
+		ret += char(0x80 | ((cp >> 6) & 0x3f));
+		ret += char(0x80 | (cp & 0x3f));
+	} else {
+		ret += char(0xf0 | (cp >> 18));
+		ret += char(0x80 | ((cp >> 12) & 0x3f));
+		ret += char(0x80 | ((cp >> 6) & 0x3f));
+		ret += char(0x80 | (cp & 0x3f));
+	}
+	return ret;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 3 || argc > 5) {
+		std::cerr << "usage:\n\t" << argv[0] << " <font.ttf> <out.atlas> [glyph_size] [spread]" << std::endl;
+		return 1;
+	}
+	std::string font_file = argv[1];
+	std::string out_file = argv[2];
+	uint32_t glyph_size = 48; //matches PlayMode::GlyphSize
+	uint32_t spread = 6; //matches PlayMode::GlyphSpread
+	if (argc > 3) glyph_size = uint32_t(std::stoul(argv[3]));
+	if (argc > 4) spread = uint32_t(std::stoul(argv[4]));
+
+	FT_Library ft_library;
+	FT_Face ft_face;
+	if (FT_Init_FreeType(&ft_library) != 0) {
+		std::cerr << "Failed to initialize FreeType." << std::endl;
+		return 1;
+	}
+	if (FT_New_Face(ft_library, font_file.c_str(), 0, &ft_face) != 0) {
+		std::cerr << "Failed to load '" << font_file << "'." << std::endl;
+		return 1;
+	}
+	FT_Set_Char_Size(ft_face, glyph_size * 64, glyph_size * 64, 0, 0);
+	hb_font_t *hb_font = hb_ft_font_create(ft_face, NULL);
+	hb_buffer_t *hb_buffer = hb_buffer_create();
+
+	//shape a string and return (glyph index, x advance) pairs:
+	auto shape = [&](std::string const &text) {
+		hb_buffer_clear_contents(hb_buffer);
+		hb_buffer_add_utf8(hb_buffer, text.c_str(), -1, 0, -1);
+		hb_buffer_guess_segment_properties(hb_buffer);
+		hb_shape(hb_font, hb_buffer, NULL, 0);
+		uint32_t len = hb_buffer_get_length(hb_buffer);
+		hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(hb_buffer, NULL);
+		hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(hb_buffer, NULL);
+		std::vector< std::pair< uint32_t, int32_t > > ret;
+		for (uint32_t i = 0; i < len; ++i) {
+			ret.emplace_back(infos[i].codepoint, positions[i].x_advance);
+		}
+		return ret;
+	};
+
+	BakedFont baked;
+	baked.header.glyph_size = glyph_size;
+	baked.header.spread = spread;
+	baked.header.ascender = int32_t(ft_face->size->metrics.ascender);
+	baked.header.descender = int32_t(ft_face->size->metrics.descender);
+	baked.header.line_height = int32_t(ft_face->size->metrics.height);
+
+	//------ which codepoints to bake ------
+	std::vector< uint32_t > wanted;
+	for (uint32_t cp = 0x20; cp <= 0x7e; ++cp) wanted.emplace_back(cp);
+	//curly quotes, dashes, ellipsis:
+	for (uint32_t cp : { 0x2018, 0x2019, 0x201c, 0x201d, 0x2013, 0x2014, 0x2026 }) wanted.emplace_back(cp);
+
+	//advance of each glyph when shaped alone:
+	std::vector< std::pair< uint32_t, int32_t > > solo(wanted.size());
+	std::set< uint32_t > to_rasterize;
+	for (uint32_t i = 0; i < wanted.size(); ++i) {
+		auto shaped = shape(utf8(wanted[i]));
+		if (shaped.size() != 1 || shaped[0].first == 0) {
+			solo[i] = std::make_pair(0, 0); //not in font (or not a single glyph); skip
+			continue;
+		}
+		solo[i] = shaped[0];
+		baked.codepoints.emplace_back();
+		baked.codepoints.back().codepoint = wanted[i];
+		baked.codepoints.back().index = shaped[0].first;
+		to_rasterize.insert(shaped[0].first);
+	}
+
+	//------ pairs: ligatures and kerning ------
+	for (uint32_t a = 0; a < wanted.size(); ++a) {
+		if (solo[a].first == 0) continue;
+		for (uint32_t b = 0; b < wanted.size(); ++b) {
+			if (solo[b].first == 0) continue;
+			auto shaped = shape(utf8(wanted[a]) + utf8(wanted[b]));
+			if (shaped.size() == 1) {
+				baked.ligatures.emplace_back();
+				baked.ligatures.back().first = wanted[a];
+				baked.ligatures.back().second = wanted[b];
+				baked.ligatures.back().index = shaped[0].first;
+				to_rasterize.insert(shaped[0].first);
+			} else if (shaped.size() == 2 && shaped[0].first == solo[a].first && shaped[1].first == solo[b].first) {
+				int32_t adjust = shaped[0].second - solo[a].second;
+				if (adjust != 0) {
+					baked.kerning.emplace_back();
+					baked.kerning.back().first = solo[a].first;
+					baked.kerning.back().second = solo[b].first;
+					baked.kerning.back().x_advance = adjust;
+				}
+			}
+			//(other substitutions aren't representable; those pairs will shape one glyph at a time)
+		}
+	}
+
+	//------ rasterize + pack ------
+	GlyphAtlas atlas;
+	for (uint32_t index : to_rasterize) {
+		FT_Load_Glyph(ft_face, index, FT_LOAD_DEFAULT);
+		FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+		FT_GlyphSlot slot = ft_face->glyph;
+
+		//n.b. advance is HarfBuzz's (which is what PlayMode would get from shaping), not FreeType's:
+		int32_t advance = hb_font_get_glyph_h_advance(hb_font, index);
+
+		GlyphAtlas::Glyph const *glyph;
+		if (slot->bitmap.width == 0 || slot->bitmap.rows == 0) {
+			glyph = atlas.insert(index, glm::uvec2(0), nullptr, 0, glm::ivec2(slot->bitmap_left, slot->bitmap_top), glm::ivec2(advance, 0));
+		} else {
+			glm::uvec2 sdf_size;
+			std::vector< uint8_t > sdf = make_sdf(glm::uvec2(slot->bitmap.width, slot->bitmap.rows), slot->bitmap.buffer, slot->bitmap.pitch, spread, &sdf_size);
+			glyph = atlas.insert(index,
+				sdf_size, sdf.data(), int32_t(sdf_size.x),
+				glm::ivec2(slot->bitmap_left - int32_t(spread), slot->bitmap_top + int32_t(spread)),
+				glm::ivec2(advance, 0)
+			);
+		}
+		if (!glyph) {
+			std::cerr << "Ran out of atlas space at glyph " << index << "; try a smaller glyph_size." << std::endl;
+			return 1;
+		}
+
+		baked.glyphs.emplace_back();
+		BakedFont::GlyphEntry &entry = baked.glyphs.back();
+		entry.index = index;
+		entry.origin = glyph->origin;
+		entry.size = glyph->size;
+		entry.bearing = glyph->bearing;
+		entry.advance = glyph->advance;
+	}
+
+	//only keep rows that were used:
+	uint32_t used_rows = 0;
+	for (auto const &shelf : atlas.shelves) {
+		used_rows = std::max(used_rows, shelf.y + shelf.height);
+	}
+	baked.header.atlas_width = atlas.size.x;
+	baked.header.atlas_height = used_rows;
+	baked.pixels.assign(atlas.pixels.begin(), atlas.pixels.begin() + atlas.size.x * used_rows);
+
+	baked.save(out_file);
+
+	std::cout << "Baked " << baked.glyphs.size() << " glyphs (" << baked.codepoints.size() << " codepoints, "
+	          << baked.ligatures.size() << " ligatures, " << baked.kerning.size() << " kerning pairs) into a "
+	          << baked.header.atlas_width << "x" << baked.header.atlas_height << " atlas: '" << out_file << "'." << std::endl;
+
+	hb_buffer_destroy(hb_buffer);
+	hb_font_destroy(hb_font);
+	FT_Done_Face(ft_face);
+	FT_Done_FreeType(ft_library);
+
+	return 0;
+}
@@ -16,6 +16,12 @@
 //for screenshots:
 #include "load_save_png.hpp"
 
+//for --soak reports:
+#include "resource_usage.hpp"
+
+//for --record and --replay:
+#include "InputLog.hpp"
+
 //Includes for libSDL:
 #include <SDL.h>
 
@@ -25,6 +31,9 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <random>
+#include <cstring>
+#include <string>
 
 #ifdef _WIN32
 extern "C" { uint32_t GetACP(); }
@@ -45,6 +54,55 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------  command line options ------------
+
+	//--soak N: run the main loop for N thousand frames with synthetic input and no vsync,
+	// periodically reporting live GL object counts and resident memory (useful for finding leaks):
+	uint32_t soak_frames = 0;
+
+	//--record FILE: log the events and frame times the game sees to FILE (see InputLog.hpp)
+	//--replay FILE: play back a log made with --record in place of live input (then continue live)
+	//--fast: with --replay, skip rendering and vsync, quit at the end of the log, and report the replay rate
+	std::string record_file;
+	std::string replay_file;
+	bool replay_fast = false;
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--soak" && argi + 1 < argc) {
+			try {
+				std::string count = argv[argi+1];
+				size_t used = 0;
+				unsigned long value = std::stoul(count, &used);
+				//(digits only -- stoul would skip spaces, accept a sign, and stop at junk -- and N * 1000 must fit in 32 bits)
+				if (count[0] < '0' || count[0] > '9' || used != count.size() || value == 0 || value > 0xffffffffUL / 1000) {
+					throw std::out_of_range("soak");
+				}
+				soak_frames = uint32_t(value) * 1000;
+			} catch (std::logic_error &) { //(std::invalid_argument or std::out_of_range)
+				std::cerr << "Expected a positive count (up to 4294967) of thousands of frames after '--soak', got '" << argv[argi+1] << "'." << std::endl;
+				std::cerr << "usage: " << argv[0] << " [--soak N] [--record FILE] [--replay FILE [--fast]]" << std::endl;
+				return 1;
+			}
+			argi += 1;
+		} else if (arg == "--record" && argi + 1 < argc) {
+			record_file = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--replay" && argi + 1 < argc) {
+			replay_file = argv[argi+1];
+			argi += 1;
+		} else if (arg == "--fast") {
+			replay_fast = true;
+		} else {
+			std::cerr << "Ignoring unrecognized command-line option '" << arg << "'." << std::endl;
+		}
+	}
+
+	if (replay_fast && replay_file.empty()) {
+		std::cerr << "Ignoring '--fast' without '--replay'." << std::endl;
+		replay_fast = false;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
@@ -72,6 +130,7 @@ int main(int argc, char **argv) {
 		SDL_WINDOW_OPENGL
 		| SDL_WINDOW_RESIZABLE //uncomment to allow resizing
 		| SDL_WINDOW_ALLOW_HIGHDPI //uncomment for full resolution on high-DPI screens
+		| (replay_fast ? SDL_WINDOW_HIDDEN : 0) //(fast replay doesn't draw anything)
 	);
 
 	//prevent exceedingly tiny windows when resizing:
@@ -95,7 +154,10 @@ int main(int argc, char **argv) {
 	init_GL();
 
 	//Set VSYNC + Late Swap (prevents crazy FPS):
-	if (SDL_GL_SetSwapInterval(-1) != 0) {
+	if (soak_frames || replay_fast) {
+		//...except when soak testing or replaying fast, where crazy FPS is the point:
+		SDL_GL_SetSwapInterval(0);
+	} else if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
 		if (SDL_GL_SetSwapInterval(1) != 0) {
 			std::cerr << "NOTE: couldn't set vsync (" << SDL_GetError() << ")." << std::endl;
@@ -131,16 +193,57 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	//state for --soak mode:
+	uint32_t soak_frame = 0;
+	std::mt19937 soak_mt(0x50a450a4);
+	GLObjectCounts soak_initial_counts;
+	size_t soak_initial_resident = 0;
+	auto soak_report = [&](GLObjectCounts const &counts, size_t resident) {
+		std::cout << "soak: frame " << soak_frame << ": " << to_string(counts) << "; ";
+		if (resident) std::cout << (resident / 1024) << " KiB resident" << std::endl;
+		else std::cout << "resident memory unavailable" << std::endl;
+	};
+
+	//state for --record and --replay:
+	std::unique_ptr< InputRecorder > recorder;
+	if (!record_file.empty()) {
+		recorder.reset(new InputRecorder(record_file));
+		std::cout << "Recording input to '" << record_file << "'." << std::endl;
+	}
+	std::unique_ptr< InputReplay > replay;
+	if (!replay_file.empty()) {
+		replay.reset(new InputReplay(replay_file));
+		std::cout << "Replaying input from '" << replay_file << "'" << (replay_fast ? " (fast)." : ".") << std::endl;
+	}
+	std::vector< SDL_Event > replay_events; //recorded events for this frame
+	float replay_elapsed = 0.0f; //recorded elapsed time for this frame
+	double replay_game_time = 0.0; //sum of replay_elapsed
+	auto replay_start = std::chrono::high_resolution_clock::now();
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
 		{ //(1) process any events that are pending
-			static SDL_Event evt;
-			while (SDL_PollEvent(&evt) == 1) {
+			//when replaying, fetch the recorded frame (or go back to live input / stop if the log is over):
+			if (replay && !replay->next_frame(&replay_events, &replay_elapsed)) {
+				double seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - replay_start).count();
+				std::cout << "Replayed " << replay->frames << " frames (" << replay_game_time << " s of play) in " << seconds << " s";
+				if (seconds > 0.0) std::cout << " (" << (replay_game_time / seconds) << "x real time)";
+				std::cout << "." << std::endl;
+				replay.reset();
+				if (replay_fast) {
+					Mode::set_current(nullptr);
+					break;
+				}
+			}
+
+			auto handle = [&](SDL_Event const &evt) {
+				if (recorder) recorder->event(evt);
 				//handle resizing:
 				if (evt.type == SDL_WINDOWEVENT && evt.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+					if (replay) SDL_SetWindowSize(window, evt.window.data1, evt.window.data2);
 					on_resize();
 				}
 				//handle input:
@@ -148,7 +251,6 @@ int main(int argc, char **argv) {
 					// mode handled it; great
 				} else if (evt.type == SDL_QUIT) {
 					Mode::set_current(nullptr);
-					break;
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
 					// --- screenshot key ---
 					std::string filename = "screenshot.png";
@@ -164,6 +266,20 @@ int main(int argc, char **argv) {
 					}
 					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
 				}
+			};
+
+			static SDL_Event evt;
+			while (SDL_PollEvent(&evt) == 1) {
+				//during replay, live input is ignored (except for closing the window):
+				if (replay && evt.type != SDL_QUIT) continue;
+				handle(evt);
+				if (!Mode::current) break;
+			}
+			if (replay) {
+				for (SDL_Event const &replay_evt : replay_events) {
+					if (!Mode::current) break;
+					handle(replay_evt);
+				}
 			}
 			if (!Mode::current) break;
 		}
@@ -178,21 +294,81 @@ int main(int argc, char **argv) {
 			//lag to avoid spiral of death:
 			elapsed = std::min(0.1f, elapsed);
 
+			//replay uses the recorded time, so the game sees exactly what it did when recording:
+			if (replay) {
+				elapsed = replay_elapsed;
+				replay_game_time += elapsed;
+			}
+			if (recorder) recorder->frame(elapsed);
+
 			Mode::current->update(elapsed);
 			if (!Mode::current) break;
 		}
 
-		{ //(3) call the current mode's "draw" function to produce output:
-		
-			Mode::current->draw(drawable_size);
+		//(fast replay only needs the game's state, so it skips drawing)
+		if (!(replay && replay_fast)) {
+			{ //(3) call the current mode's "draw" function to produce output:
+			
+				Mode::current->draw(drawable_size);
+			}
+
+			//Wait until the recently-drawn frame is shown before doing it all again:
+			SDL_GL_SwapWindow(window);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		if (soak_frames) { //(4) in soak mode, poke the game and keep an eye on resources:
+			soak_frame += 1;
+
+			//every few frames, press a key (mostly choices, sometimes restart):
+			if (soak_frame % 5 == 0) {
+				SDL_Keycode const keys[] = { SDLK_LEFT, SDLK_RIGHT, SDLK_LEFT, SDLK_RIGHT, SDLK_r };
+				SDL_Event evt;
+				std::memset(&evt, 0, sizeof(evt));
+				evt.type = SDL_KEYDOWN;
+				evt.key.keysym.sym = keys[soak_mt() % (sizeof(keys) / sizeof(keys[0]))];
+				SDL_PushEvent(&evt);
+			}
+
+			if (soak_frame == 1 || soak_frame % 1000 == 0 || soak_frame >= soak_frames) {
+				GLObjectCounts counts = count_gl_objects();
+				size_t resident = resident_memory_bytes();
+				if (soak_frame == 1) {
+					soak_initial_counts = counts;
+					soak_initial_resident = resident;
+				}
+				soak_report(counts, resident);
+
+				//re-create the mode, so per-mode setup/teardown gets exercised too:
+				if (soak_frame % 1000 == 0 && soak_frame != soak_frames) {
+					Mode::set_current(std::make_shared< PlayMode >());
+				}
+			}
+
+			if (soak_frame >= soak_frames) {
+				GLObjectCounts counts = count_gl_objects();
+				size_t resident = resident_memory_bytes();
+				std::cout << "soak: done after " << soak_frame << " frames. Change since frame 1: "
+					<< (int64_t(counts.buffers) - int64_t(soak_initial_counts.buffers)) << " buffers, "
+					<< (int64_t(counts.vertex_arrays) - int64_t(soak_initial_counts.vertex_arrays)) << " vertex arrays, "
+					<< (int64_t(counts.textures) - int64_t(soak_initial_counts.textures)) << " textures, "
+					<< (int64_t(counts.programs) - int64_t(soak_initial_counts.programs)) << " programs, ";
+				if (resident && soak_initial_resident) {
+					std::cout << ((int64_t(resident) - int64_t(soak_initial_resident)) / 1024) << " KiB resident." << std::endl;
+				} else {
+					std::cout << "resident memory unavailable." << std::endl;
+				}
+				Mode::set_current(nullptr);
+			}
+		}
 	}
 
 
 	//------------  teardown ------------
+	if (recorder) {
+		std::cout << "Recorded " << recorder->frames << " frames to '" << record_file << "'." << std::endl;
+		recorder.reset();
+	}
+
 	Sound::shutdown();
 
 	SDL_GL_DeleteContext(context);
@@ -0,0 +1,102 @@
+#include "make_sdf.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//Distance transform approach follows Felzenszwalb & Huttenlocher, "Distance Transforms of Sampled Functions" (2012),
+// with partial-coverage seeding as in Mapbox's TinySDF (https://github.com/mapbox/tiny-sdf).
+
+static constexpr float Far = 1e20f;
+
+//one-dimensional squared-distance transform of 'count' samples spaced 'stride' apart in 'grid' (in place):
+static void edt_1d(float *grid, uint32_t offset, uint32_t stride, uint32_t count, std::vector< float > &f, std::vector< uint32_t > &v, std::vector< float > &z) {
+	for (uint32_t q = 0; q < count; ++q) {
+		f[q] = grid[offset + q * stride];
+	}
+
+	//squared distance parabolas rooted at samples r and q intersect at:
+	auto intersect = [&f](uint32_t r, uint32_t q) {
+		return ((f[q] + float(q) * float(q)) - (f[r] + float(r) * float(r))) / (2.0f * float(q) - 2.0f * float(r));
+	};
+
+	//compute lower envelope of parabolas rooted at each sample:
+	// (z[0] is -Far, so k never goes below zero)
+	uint32_t k = 0;
+	v[0] = 0;
+	z[0] = -Far;
+	z[1] = Far;
+	for (uint32_t q = 1; q < count; ++q) {
+		float s = intersect(v[k], q);
+		while (s <= z[k]) {
+			k -= 1;
+			s = intersect(v[k], q);
+		}
+		k += 1;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = Far;
+	}
+
+	//sample the envelope:
+	k = 0;
+	for (uint32_t q = 0; q < count; ++q) {
+		while (z[k+1] < float(q)) k += 1;
+		float dq = float(q) - float(v[k]);
+		grid[offset + q * stride] = dq * dq + f[v[k]];
+	}
+}
+
+//two-dimensional squared-distance transform (in place):
+static void edt_2d(std::vector< float > &grid, glm::uvec2 size) {
+	uint32_t n = std::max(size.x, size.y);
+	std::vector< float > f(n);
+	std::vector< uint32_t > v(n);
+	std::vector< float > z(n + 1);
+	for (uint32_t x = 0; x < size.x; ++x) {
+		edt_1d(grid.data(), x, size.x, size.y, f, v, z);
+	}
+	for (uint32_t y = 0; y < size.y; ++y) {
+		edt_1d(grid.data(), y * size.x, 1, size.x, f, v, z);
+	}
+}
+
+std::vector< uint8_t > make_sdf(glm::uvec2 size, uint8_t const *coverage, int32_t pitch, uint32_t spread, glm::uvec2 *out_size_) {
+	assert(out_size_);
+	assert(spread > 0);
+	glm::uvec2 &out_size = *out_size_;
+
+	out_size = size + glm::uvec2(2 * spread);
+
+	//outer: squared distance to the shape; inner: squared distance to the background
+	// (pixels with partial coverage are seeded with their approximate sub-pixel distance to the edge)
+	std::vector< float > outer(out_size.x * out_size.y, Far);
+	std::vector< float > inner(out_size.x * out_size.y, 0.0f);
+	for (uint32_t y = 0; y < size.y; ++y) {
+		uint8_t const *row = coverage + int32_t(y) * pitch;
+		for (uint32_t x = 0; x < size.x; ++x) {
+			float c = row[x] / 255.0f;
+			uint32_t i = (y + spread) * out_size.x + (x + spread);
+			if (c >= 1.0f) {
+				outer[i] = 0.0f;
+				inner[i] = Far;
+			} else if (c > 0.0f) {
+				float d = 0.5f - c;
+				outer[i] = (d > 0.0f ? d * d : 0.0f);
+				inner[i] = (d < 0.0f ? d * d : 0.0f);
+			}
+		}
+	}
+
+	edt_2d(outer, out_size);
+	edt_2d(inner, out_size);
+
+	std::vector< uint8_t > sdf(out_size.x * out_size.y);
+	for (uint32_t i = 0; i < sdf.size(); ++i) {
+		float d = std::sqrt(outer[i]) - std::sqrt(inner[i]); //positive outside the shape
+		float value = 0.5f - d / (2.0f * float(spread));
+		sdf[i] = uint8_t(std::round(255.0f * std::min(1.0f, std::max(0.0f, value))));
+	}
+
+	return sdf;
+}
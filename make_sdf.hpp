@@ -0,0 +1,15 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+//Build a signed distance field from an 8-bit coverage bitmap (e.g., a FreeType glyph):
+// 'pitch' is the (signed) distance in bytes between rows of 'coverage', as in FT_Bitmap
+// 'spread' is the largest distance (in pixels) the field represents; the output is
+//   padded by 'spread' pixels on every side, so it is (size + 2 * spread) pixels big.
+// Output values are 128 on the outline, increasing inside the shape and decreasing
+//  outside it, reaching 255 / 0 at 'spread' pixels from the outline.
+//  (i.e., value / 255 = 0.5 + signed_distance / (2 * spread))
+std::vector< uint8_t > make_sdf(glm::uvec2 size, uint8_t const *coverage, int32_t pitch, uint32_t spread, glm::uvec2 *out_size);
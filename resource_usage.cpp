@@ -0,0 +1,60 @@
+#include "resource_usage.hpp"
+
+#include "GL.hpp"
+
+#include <fstream>
+
+#if defined(_WIN32)
+#undef APIENTRY //(GL.hpp's version; windows.h defines its own)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+GLObjectCounts count_gl_objects(uint32_t max_name) {
+	GLObjectCounts counts;
+	for (GLuint name = 1; name <= max_name; ++name) {
+		if (glIsBuffer(name)) counts.buffers += 1;
+		if (glIsVertexArray(name)) counts.vertex_arrays += 1;
+		if (glIsTexture(name)) counts.textures += 1;
+		if (glIsProgram(name)) counts.programs += 1;
+	}
+	return counts;
+}
+
+size_t resident_memory_bytes() {
+	#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return size_t(counters.WorkingSetSize);
+	}
+	return 0;
+	#elif defined(__APPLE__)
+	mach_task_basic_info_data_t info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, task_info_t(&info), &count) == KERN_SUCCESS) {
+		return size_t(info.resident_size);
+	}
+	return 0;
+	#elif defined(__linux__)
+	//second field of /proc/self/statm is resident pages:
+	std::ifstream statm("/proc/self/statm");
+	size_t total_pages = 0, resident_pages = 0;
+	if (statm >> total_pages >> resident_pages) {
+		return resident_pages * size_t(sysconf(_SC_PAGESIZE));
+	}
+	return 0;
+	#else
+	return 0;
+	#endif
+}
+
+std::string to_string(GLObjectCounts const &counts) {
+	return std::to_string(counts.buffers) + " buffers, "
+	     + std::to_string(counts.vertex_arrays) + " vertex arrays, "
+	     + std::to_string(counts.textures) + " textures, "
+	     + std::to_string(counts.programs) + " programs";
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+/*
+ * Helpers for keeping an eye on resource usage during long runs
+ *  (e.g., the game's --soak mode):
+ *
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+//Count live OpenGL objects by probing names [1, max_name] with glIs*:
+// (this is slow-ish, so call it occasionally -- not every frame)
+// (requires a current GL context)
+struct GLObjectCounts {
+	uint32_t buffers = 0;
+	uint32_t vertex_arrays = 0;
+	uint32_t textures = 0;
+	uint32_t programs = 0;
+};
+GLObjectCounts count_gl_objects(uint32_t max_name = 65536);
+
+//Resident set size (working set, on windows) of this process in bytes:
+// (0 if it can't be read, e.g., on platforms other than linux, macos, and windows)
+size_t resident_memory_bytes();
+
+//Format the above as a single line for logging:
+std::string to_string(GLObjectCounts const &counts);
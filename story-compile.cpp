@@ -0,0 +1,35 @@
+//Offline story compiler: reads a story's text form (see dist/story.txt)
+// and writes the binary form the game maps at startup (see Story.hpp).
+//
+// usage: story-compile <story.txt> <out.bin>
+
+#include "StorySource.hpp"
+
+#include <iostream>
+
+int main(int argc, char **argv) {
+	if (argc != 3) {
+		std::cerr << "usage:\n\t" << argv[0] << " <story.txt> <out.bin>" << std::endl;
+		return 1;
+	}
+	std::string in_file = argv[1];
+	std::string out_file = argv[2];
+
+	try {
+		StorySource source(in_file);
+		source.save(out_file);
+
+		//check that the result maps back in:
+		Story story(out_file);
+
+		std::cout << "Wrote '" << out_file << "': " << story.nodes.size() << " nodes, "
+			<< story.edges.size() << " edges, " << story.conditions.size() << " conditions, "
+			<< story.bits.size() << " bits, " << story.strings.size() << " strings ("
+			<< story.string_data.size() << " bytes)." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,317 @@
+//Story state-space explorer: breadth-first search over every GameState
+// (node + items + flags) reachable from the start of a compiled story, then
+// a report for content authors:
+//  - how many states are reachable, and which nodes never are
+//  - endings reached, and states that can no longer win ("dead"), including
+//    soft-locks (not an ending, but no way to win)
+//  - the shortest choice sequence to each winning node
+//  - story text that can never be shown, and edges that can never be taken
+//
+// Each BFS level is expanded in parallel; states are deduplicated in sharded
+// hash sets (by GameState::hash()), each shard owned by one thread, so the
+// search scales to stories with millions of states. Results don't depend on
+// the thread count.
+//
+// usage: story-explore <story.bin> [threads]
+
+#include "Story.hpp"
+#include "GameState.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//run body(i) for i in [0,count) on up to 'threads' threads:
+static void parallel_for(uint32_t threads, size_t count, std::function< void(size_t) > const &body) {
+	if (threads <= 1 || count <= 1) {
+		for (size_t i = 0; i < count; ++i) body(i);
+		return;
+	}
+	std::atomic< size_t > next(0);
+	std::vector< std::thread > workers;
+	for (uint32_t t = 0; t < threads && t < count; ++t) {
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < count; i = next++) body(i);
+		});
+	}
+	for (auto &worker : workers) worker.join();
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 3) {
+		std::cerr << "usage:\n\t" << argv[0] << " <story.bin> [threads]" << std::endl;
+		return 1;
+	}
+	uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+	if (argc > 2) threads = std::max(1u, uint32_t(std::stoul(argv[2])));
+
+	try {
+		Story story(argv[1]);
+
+		static constexpr uint32_t None = Story::Invalid;
+
+		//every reachable state, in BFS order (so parents come before children):
+		struct Record {
+			GameState state;
+			uint32_t parent; //index of state this was first reached from (None for the start)
+			uint32_t edge; //edge taken from parent
+			uint32_t next[2]; //state reached by choosing each side (None if the choice does nothing)
+			uint32_t depth; //choices from the start
+		};
+		std::vector< Record > records;
+
+		//visited states -> record index, split into shards by hash so each can be filled by one thread:
+		uint32_t const ShardBits = 6;
+		uint32_t const Shards = 1u << ShardBits;
+		auto shard_of = [&](GameState const &state) {
+			return uint32_t(state.hash() >> (sizeof(size_t) * 8 - ShardBits));
+		};
+		std::vector< std::unordered_map< GameState, uint32_t > > visited(Shards);
+
+		//candidate successors of one level:
+		struct Candidate {
+			GameState state;
+			uint32_t parent; //None for an empty slot (choice does nothing)
+			uint32_t side;
+			uint32_t edge;
+			uint32_t found; //record index (or New | index among its shard's new states, until those are appended)
+		};
+		static constexpr uint32_t New = 0x80000000;
+
+		auto before = std::chrono::high_resolution_clock::now();
+
+		{
+			GameState start = story.start();
+			records.emplace_back(Record{ start, None, None, { None, None }, 0 });
+			visited[shard_of(start)].emplace(start, 0);
+		}
+
+		size_t level_begin = 0;
+		uint32_t depth = 0;
+		std::vector< Candidate > candidates;
+		std::vector< std::vector< uint32_t > > shard_candidates(Shards); //candidates in each shard (in order)
+		std::vector< std::vector< uint32_t > > shard_new(Shards); //candidates that were new states, per shard
+		while (level_begin < records.size()) {
+			size_t level_end = records.size();
+
+			//expand the level (two candidate slots per state):
+			candidates.assign((level_end - level_begin) * 2, Candidate{ GameState(), None, 0, None, None });
+			parallel_for(threads, (level_end - level_begin + 1023) / 1024, [&](size_t block) {
+				size_t end = std::min(level_end, level_begin + (block + 1) * 1024);
+				for (size_t r = level_begin + block * 1024; r < end; ++r) {
+					for (uint32_t side = 0; side < 2; ++side) {
+						uint32_t e = story.choose(records[r].state, Story::Side(side));
+						if (e == Story::Invalid) continue;
+						Candidate &c = candidates[(r - level_begin) * 2 + side];
+						c.state = story.take(records[r].state, e);
+						c.parent = uint32_t(r);
+						c.edge = e;
+						c.side = side;
+					}
+				}
+			});
+
+			//dedup, one thread per shard (each shard sees its candidates in order, so results are deterministic):
+			for (auto &list : shard_candidates) list.clear();
+			for (uint32_t i = 0; i < candidates.size(); ++i) {
+				if (candidates[i].parent != None) shard_candidates[shard_of(candidates[i].state)].emplace_back(i);
+			}
+			parallel_for(threads, Shards, [&](size_t s) {
+				shard_new[s].clear();
+				for (uint32_t i : shard_candidates[s]) {
+					Candidate &c = candidates[i];
+					auto ret = visited[s].emplace(c.state, New | uint32_t(shard_new[s].size()));
+					if (ret.second) shard_new[s].emplace_back(i);
+					c.found = ret.first->second;
+				}
+			});
+
+			//append new states shard by shard:
+			std::vector< uint32_t > shard_base(Shards);
+			for (uint32_t s = 0; s < Shards; ++s) {
+				shard_base[s] = uint32_t(records.size());
+				for (uint32_t i : shard_new[s]) {
+					Candidate const &c = candidates[i];
+					records.emplace_back(Record{ c.state, c.parent, c.edge, { None, None }, depth + 1 });
+				}
+			}
+			if (records.size() >= New) throw std::runtime_error("Too many states (more than " + std::to_string(New) + ").");
+
+			//resolve new-state indices and link parents to children:
+			parallel_for(threads, Shards, [&](size_t s) {
+				for (uint32_t i : shard_new[s]) {
+					uint32_t &index = visited[s][candidates[i].state];
+					index = shard_base[s] + (index & ~New);
+				}
+				for (uint32_t i : shard_candidates[s]) {
+					Candidate &c = candidates[i];
+					if (c.found & New) c.found = shard_base[s] + (c.found & ~New);
+					records[c.parent].next[c.side] = c.found;
+				}
+			});
+
+			level_begin = level_end;
+			depth += 1;
+		}
+
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+
+		//which states can still reach a win? (walk edges backwards from winning states)
+		std::vector< uint8_t > can_win(records.size(), 0);
+		{
+			std::vector< uint32_t > reverse_begin(records.size() + 1, 0);
+			for (Record const &record : records) {
+				for (uint32_t n : record.next) if (n != None) reverse_begin[n + 1] += 1;
+			}
+			for (size_t i = 0; i < records.size(); ++i) reverse_begin[i + 1] += reverse_begin[i];
+			std::vector< uint32_t > reverse(reverse_begin.back());
+			std::vector< uint32_t > fill(reverse_begin.begin(), reverse_begin.end() - 1);
+			for (uint32_t r = 0; r < records.size(); ++r) {
+				for (uint32_t n : records[r].next) if (n != None) reverse[fill[n]++] = r;
+			}
+			std::vector< uint32_t > todo;
+			for (uint32_t r = 0; r < records.size(); ++r) {
+				if (story.nodes[records[r].state.node].flags & Story::NodeWin) {
+					can_win[r] = 1;
+					todo.emplace_back(r);
+				}
+			}
+			while (!todo.empty()) {
+				uint32_t r = todo.back();
+				todo.pop_back();
+				for (uint32_t i = reverse_begin[r]; i < reverse_begin[r + 1]; ++i) {
+					if (!can_win[reverse[i]]) {
+						can_win[reverse[i]] = 1;
+						todo.emplace_back(reverse[i]);
+					}
+				}
+			}
+		}
+
+		auto name = [&](uint32_t node) {
+			return std::string(story.string(story.nodes[node].name));
+		};
+
+		//------ report ------
+		std::cout << "story-explore: " << records.size() << " reachable states, " << depth << " levels deep, in "
+			<< seconds << " s on " << threads << " threads (" << (records.size() / seconds / 1e6) << " M states/s)." << std::endl;
+
+		std::vector< uint32_t > node_states(story.nodes.size(), 0);
+		std::vector< uint8_t > edge_taken(story.edges.size(), 0);
+		std::vector< uint8_t > string_shown(story.strings.size(), 0);
+		string_shown[story.start_result] = 1;
+		for (Record const &record : records) {
+			node_states[record.state.node] += 1;
+			Story::Node const &node = story.nodes[record.state.node];
+			string_shown[node.message] = string_shown[node.left] = string_shown[node.right] = 1;
+			for (uint32_t side = 0; side < 2; ++side) {
+				uint32_t e = story.choose(record.state, Story::Side(side));
+				if (e != Story::Invalid) {
+					edge_taken[e] = 1;
+					string_shown[story.edges[e].result] = 1;
+				}
+			}
+		}
+
+		uint32_t reached_nodes = 0;
+		for (uint32_t count : node_states) reached_nodes += (count > 0);
+		std::cout << "Nodes: " << reached_nodes << " of " << story.nodes.size() << " reachable." << std::endl;
+		for (uint32_t n = 0; n < story.nodes.size(); ++n) {
+			if (node_states[n] == 0) std::cout << "  unreachable node: " << name(n) << std::endl;
+		}
+
+		//endings and dead states:
+		uint64_t dead = 0, soft_locked = 0;
+		std::vector< uint32_t > ending_states(story.nodes.size(), 0);
+		std::vector< uint32_t > soft_locked_at(story.nodes.size(), 0);
+		for (uint32_t r = 0; r < records.size(); ++r) {
+			uint32_t n = records[r].state.node;
+			if (story.is_ending(n)) ending_states[n] += 1;
+			if (!can_win[r]) {
+				dead += 1;
+				if (!story.is_ending(n)) {
+					soft_locked += 1;
+					soft_locked_at[n] += 1;
+				}
+			}
+		}
+		std::cout << "Endings:" << std::endl;
+		for (uint32_t n = 0; n < story.nodes.size(); ++n) {
+			if (ending_states[n] == 0) continue;
+			std::cout << "  " << name(n) << ((story.nodes[n].flags & Story::NodeWin) ? " (win)" : "") << ": " << ending_states[n] << " states" << std::endl;
+		}
+		std::cout << "Dead states (no way left to win): " << dead << ", of which " << soft_locked << " are soft-locks (not an ending)." << std::endl;
+		for (uint32_t n = 0; n < story.nodes.size(); ++n) {
+			if (soft_locked_at[n]) std::cout << "  soft-lock at " << name(n) << ": " << soft_locked_at[n] << " states" << std::endl;
+		}
+
+		//shortest solution to each winning node (BFS order means the first record found is the shortest):
+		std::cout << "Shortest solutions:" << std::endl;
+		std::vector< uint8_t > solved(story.nodes.size(), 0);
+		for (uint32_t r = 0; r < records.size(); ++r) {
+			uint32_t n = records[r].state.node;
+			if (!(story.nodes[n].flags & Story::NodeWin) || solved[n]) continue;
+			solved[n] = 1;
+			std::vector< uint32_t > path;
+			for (uint32_t at = r; records[at].parent != None; at = records[at].parent) path.emplace_back(at);
+			std::reverse(path.begin(), path.end());
+			//(an edge is a left choice if it is in its node's left range)
+			auto is_left = [&](uint32_t at) {
+				return records[at].edge < story.nodes[records[records[at].parent].state.node].edges[1];
+			};
+			std::string keys;
+			for (uint32_t at : path) keys += (is_left(at) ? 'L' : 'R');
+			std::cout << "  " << name(n) << " in " << path.size() << " choices: " << keys << std::endl;
+			for (uint32_t at : path) {
+				uint32_t from = records[records[at].parent].state.node;
+				std::cout << "    " << name(from) << ": " << story.string(is_left(at) ? story.nodes[from].left : story.nodes[from].right) << std::endl;
+			}
+		}
+		for (uint32_t n = 0; n < story.nodes.size(); ++n) {
+			if ((story.nodes[n].flags & Story::NodeWin) && !solved[n]) std::cout << "  " << name(n) << ": no solution!" << std::endl;
+		}
+
+		//text and edges that play never reaches:
+		std::vector< uint8_t > is_text(story.strings.size(), 0);
+		is_text[story.start_result] = 1;
+		for (Story::Node const &node : story.nodes) {
+			is_text[node.message] = is_text[node.left] = is_text[node.right] = 1;
+		}
+		for (Story::Edge const &edge : story.edges) is_text[edge.result] = 1;
+		uint32_t unshown = 0;
+		for (uint32_t s = 0; s < story.strings.size(); ++s) {
+			if (is_text[s] && !string_shown[s]) {
+				if (unshown == 0) std::cout << "Text never shown:" << std::endl;
+				std::cout << "  \"" << story.string(s) << "\"" << std::endl;
+				unshown += 1;
+			}
+		}
+		if (unshown == 0) std::cout << "All text can be shown." << std::endl;
+
+		uint32_t untaken = 0;
+		for (uint32_t n = 0; n < story.nodes.size(); ++n) {
+			Story::Node const &node = story.nodes[n];
+			for (uint32_t e = node.edges[0]; e < node.edges[2]; ++e) {
+				if (edge_taken[e]) continue;
+				if (untaken == 0) std::cout << "Edges never taken:" << std::endl;
+				std::cout << "  " << name(n) << (e < node.edges[1] ? " left" : " right") << " -> " << name(story.edges[e].target)
+					<< " \"" << story.string(story.edges[e].result) << "\"" << std::endl;
+				untaken += 1;
+			}
+		}
+		if (untaken == 0) std::cout << "Every edge can be taken." << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,271 @@
+//Choice fuzzer: drives the game's rules (Playthrough.hpp) with random and
+// adversarial choice streams -- including frames with no choice, bursts of the
+// same choice, restarts, and rewinds -- and checks invariants after every step:
+//  - the state's location is its node's location, and that location's camera exists
+//  - nodes that aren't endings have a message and non-empty left/right choices
+//  - results and state bits stay in range
+//  - doing nothing, or choosing at an ending, changes nothing
+//  - restarting lands at the start; snapshots restore exactly
+//  - making a choice doesn't allocate
+//
+// Half of the choices are "adversarial": they pick the side whose edge has been
+// taken least so far, which pushes into rarely-visited parts of the story.
+//
+// Every choice is timed, and the report gives the latency distribution
+// (p50/p99/p99.9/max) from a log-scale histogram, so changes that slow down
+// or start allocating in the rules show up here.
+//
+// On failure, prints the seed, step, and recent operations, and exits with code 1.
+//
+// usage: story-fuzz <story.bin> [--steps <n>] [--seed <seed>] [--cameras <n>] [--max-p99 <ns>]
+
+#include "Playthrough.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+//count allocations, to check that choices don't allocate:
+static std::atomic< uint64_t > allocations(0);
+
+void *operator new(size_t size) {
+	allocations += 1;
+	if (void *ret = std::malloc(size ? size : 1)) return ret;
+	throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+	std::free(ptr);
+}
+
+//Latency histogram with log-scale buckets: SubBuckets per power of two, so each bucket is within ~1/SubBuckets of its value:
+struct LatencyHistogram {
+	static constexpr uint32_t SubBits = 3;
+	static constexpr uint32_t SubBuckets = 1u << SubBits;
+	static constexpr uint32_t Buckets = 64 * SubBuckets;
+
+	std::vector< uint64_t > counts = std::vector< uint64_t >(Buckets, 0);
+	uint64_t total = 0;
+	uint64_t max = 0;
+
+	static uint32_t bucket(uint64_t ns) {
+		if (ns < SubBuckets) return uint32_t(ns);
+		uint32_t top = SubBits; //highest set bit (ns >= SubBuckets, so top >= SubBits)
+		while ((ns >> top) > 1) ++top;
+		uint32_t sub = uint32_t(ns >> (top - SubBits)) & (SubBuckets - 1);
+		return (top - SubBits + 1) * SubBuckets + sub;
+	}
+	//smallest value that lands in bucket 'b':
+	static uint64_t value(uint32_t b) {
+		if (b < SubBuckets) return b;
+		uint32_t top = b / SubBuckets - 1 + SubBits;
+		return (uint64_t(SubBuckets + b % SubBuckets)) << (top - SubBits);
+	}
+
+	void add(uint64_t ns) {
+		counts[bucket(ns)] += 1;
+		total += 1;
+		max = std::max(max, ns);
+	}
+	//value below which a fraction 'p' of samples fall (to bucket precision):
+	uint64_t percentile(double p) const {
+		uint64_t want = uint64_t(p * double(total));
+		uint64_t seen = 0;
+		for (uint32_t b = 0; b < Buckets; ++b) {
+			seen += counts[b];
+			if (seen > want) return std::min(max, value(b + 1));
+		}
+		return max;
+	}
+};
+
+static void usage(char const *exe) {
+	std::cerr << "usage:\n"
+		<< "\t" << exe << " <story.bin> [--steps <n>] [--seed <seed>] [--cameras <n>] [--max-p99 <ns>]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string story_file = argv[1];
+	uint64_t steps = 1000000;
+	uint32_t seed = 0xf022;
+	uint32_t cameras = 0; //(0: don't check cameras)
+	uint64_t max_p99 = 0; //(0: don't check latency)
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--steps" && i + 1 < argc) {
+			steps = std::stoull(argv[++i]);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			seed = uint32_t(std::stoul(argv[++i]));
+		} else if (arg == "--cameras" && i + 1 < argc) {
+			cameras = uint32_t(std::stoul(argv[++i]));
+		} else if (arg == "--max-p99" && i + 1 < argc) {
+			max_p99 = std::stoull(argv[++i]);
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	try {
+		Story story(story_file);
+		Playthrough play(story);
+		SnapshotRing history;
+
+		std::mt19937 mt(seed);
+		std::vector< uint64_t > edge_hits(story.edges.size(), 0);
+		LatencyHistogram latency;
+
+		//recent operations, for failure reports:
+		std::deque< std::string > recent;
+		auto note = [&](std::string const &op) {
+			recent.emplace_back(op);
+			if (recent.size() > 32) recent.pop_front();
+		};
+
+		uint64_t step = 0;
+		auto fail = [&](std::string const &what) {
+			std::cerr << "story-fuzz: FAILED at step " << step << " (seed " << seed << "): " << what << std::endl;
+			std::cerr << "  at node " << story.string(story.nodes[play.state.node].name) << ", bits " << play.state.bits << std::endl;
+			std::cerr << "  recent operations:";
+			for (auto const &op : recent) std::cerr << " " << op;
+			std::cerr << std::endl;
+			std::exit(1);
+		};
+
+		uint64_t used_bits = (story.bits.size() >= Story::MaxBits ? ~uint64_t(0) : (uint64_t(1) << story.bits.size()) - 1);
+		auto check = [&]() {
+			GameState const &s = play.state;
+			if (s.node >= story.nodes.size()) fail("node out of range");
+			Story::Node const &node = story.nodes[s.node];
+			if (s.location != node.location) fail("location doesn't match node");
+			if (cameras && story.locations[s.location].camera >= cameras) fail("location's camera doesn't exist");
+			if (s.bits & ~used_bits) fail("unused state bits set");
+			if (play.result >= story.strings.size()) fail("result out of range");
+			if (!play.ended()) {
+				if (story.string(node.message).empty()) fail("empty message at a node that isn't an ending");
+				if (story.string(node.left).empty()) fail("empty left choice at a node that isn't an ending");
+				if (story.string(node.right).empty()) fail("empty right choice at a node that isn't an ending");
+			}
+		};
+
+		//make a choice (timed, and checked not to allocate):
+		uint64_t transitions = 0;
+		auto choose = [&](Story::Side side) {
+			GameState before = play.state;
+			bool was_ended = play.ended();
+			uint64_t allocations_before = allocations;
+			auto t0 = std::chrono::steady_clock::now();
+			uint32_t e = play.choose(side);
+			auto t1 = std::chrono::steady_clock::now();
+			if (allocations != allocations_before) fail("choice allocated memory");
+			latency.add(uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(t1 - t0).count()));
+			if (e == Story::Invalid) {
+				if (play.state != before) fail("choice that did nothing changed the state");
+			} else {
+				if (was_ended) fail("choice did something at an ending");
+				edge_hits[e] += 1;
+				transitions += 1;
+			}
+		};
+
+		//least-taken side (adversarial choice):
+		auto rare_side = [&]() {
+			uint32_t l = story.choose(play.state, Story::Left);
+			uint32_t r = story.choose(play.state, Story::Right);
+			uint64_t lh = (l == Story::Invalid ? ~uint64_t(0) : edge_hits[l]);
+			uint64_t rh = (r == Story::Invalid ? ~uint64_t(0) : edge_hits[r]);
+			if (lh == rh) return Story::Side(mt() & 1);
+			return (lh < rh ? Story::Left : Story::Right);
+		};
+
+		auto before = std::chrono::high_resolution_clock::now();
+		check();
+		while (step < steps) {
+			uint32_t op = mt() % 100;
+			if (op < 40) { //random choice
+				Story::Side side = Story::Side(mt() & 1);
+				note(side == Story::Left ? "L" : "R");
+				history.push(play.snapshot());
+				choose(side);
+			} else if (op < 80) { //adversarial choice
+				Story::Side side = rare_side();
+				note(side == Story::Left ? "l" : "r");
+				history.push(play.snapshot());
+				choose(side);
+			} else if (op < 88) { //no choice this frame
+				note(".");
+				GameState prev = play.state;
+				uint32_t prev_result = play.result;
+				play.tick(1.0f / 60.0f);
+				if (play.state != prev || play.result != prev_result) fail("no choice changed the state");
+			} else if (op < 94) { //burst of one choice
+				Story::Side side = Story::Side(mt() & 1);
+				uint32_t count = 2 + mt() % 15;
+				note(std::string(side == Story::Left ? "L" : "R") + "*" + std::to_string(count));
+				for (uint32_t i = 0; i < count; ++i) {
+					choose(side);
+					check();
+				}
+			} else if (op < 97) { //rewind
+				note("<");
+				Playthrough::Snapshot snapshot;
+				if (history.pop(&snapshot)) {
+					play.restore(snapshot);
+					if (play.state != snapshot.state || play.result != snapshot.result) fail("restore doesn't match snapshot");
+				}
+			} else { //restart
+				note("X");
+				play.restart();
+				history.clear();
+				if (play.state != story.start()) fail("restart isn't at the start");
+			}
+			check();
+
+			//snapshots round-trip:
+			Playthrough::Snapshot snapshot = play.snapshot();
+			play.restore(snapshot);
+			if (play.state != snapshot.state) fail("snapshot doesn't round-trip");
+
+			//start over at endings (after checking that they stay put):
+			if (play.ended() && (mt() & 3) == 0) {
+				note("X");
+				play.restart();
+				history.clear();
+			}
+			step += 1;
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+
+		uint32_t edges_taken = 0;
+		for (uint64_t hits : edge_hits) edges_taken += (hits > 0);
+
+		std::cout << "story-fuzz: " << steps << " steps (seed " << seed << ") in " << seconds << " s; invariants held." << std::endl;
+		std::cout << "  " << latency.total << " choices, " << transitions << " transitions, " << edges_taken << " of " << story.edges.size() << " edges taken." << std::endl;
+		std::cout << "  choice latency: p50 " << latency.percentile(0.5) << " ns, p99 " << latency.percentile(0.99)
+			<< " ns, p99.9 " << latency.percentile(0.999) << " ns, max " << latency.max << " ns (includes timer overhead)." << std::endl;
+
+		if (max_p99 && latency.percentile(0.99) > max_p99) {
+			std::cerr << "story-fuzz: p99 choice latency is over " << max_p99 << " ns." << std::endl;
+			return 1;
+		}
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
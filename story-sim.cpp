@@ -0,0 +1,126 @@
+//Command-line story driver: runs the game's rules (Playthrough.hpp) on a
+// compiled story without a window, GL context, or fonts.
+//
+// Scripted mode plays a fixed sequence of choices and prints each step;
+// with --expect it fails (exit code 1) unless the script ends at the named
+// node, so story logic can be regression-tested on build machines.
+//
+// Random mode makes seeded random choices (restarting at endings) and
+// reports how fast the rules run.
+//
+// usage: story-sim <story.bin> --script <choices> [--expect <node>]
+//        story-sim <story.bin> [--random <steps>] [--seed <seed>]
+//  where <choices> is a string of 'L' (left), 'R' (right), and 'X' (restart).
+
+#include "Playthrough.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+static void usage(char const *exe) {
+	std::cerr << "usage:\n"
+		<< "\t" << exe << " <story.bin> --script <choices> [--expect <node>]\n"
+		<< "\t" << exe << " <story.bin> [--random <steps>] [--seed <seed>]\n"
+		<< " where <choices> is a string of 'L' (left), 'R' (right), and 'X' (restart)." << std::endl;
+}
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	std::string story_file = argv[1];
+	std::string script;
+	bool scripted = false;
+	std::string expect;
+	uint64_t steps = 10000000;
+	uint32_t seed = 0x5eed;
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--script" && i + 1 < argc) {
+			scripted = true;
+			script = argv[++i];
+		} else if (arg == "--expect" && i + 1 < argc) {
+			expect = argv[++i];
+		} else if (arg == "--random" && i + 1 < argc) {
+			steps = std::stoull(argv[++i]);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			seed = uint32_t(std::stoul(argv[++i]));
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	try {
+		Story story(story_file);
+		Playthrough play(story);
+
+		auto node_name = [&](uint32_t node) {
+			return std::string(story.string(story.nodes[node].name));
+		};
+
+		if (scripted) {
+			for (char c : script) {
+				if (c == 'X') {
+					play.restart();
+					std::cout << "X: restart at " << node_name(play.state.node) << std::endl;
+					continue;
+				}
+				if (c != 'L' && c != 'R') {
+					std::cerr << "Unexpected '" << c << "' in script." << std::endl;
+					return 1;
+				}
+				play.tick(1.0f); //(one second per choice, for time-to-crate)
+				uint32_t from = play.state.node;
+				if (play.choose(c == 'L' ? Story::Left : Story::Right) == Story::Invalid) {
+					std::cout << c << ": " << node_name(from) << " (nothing happens)" << std::endl;
+				} else {
+					std::cout << c << ": " << node_name(from) << " -> " << node_name(play.state.node)
+						<< " \"" << (play.result_needs_format() ? play.format_result() : std::string(story.string(play.result))) << "\"" << std::endl;
+				}
+			}
+			std::string end = node_name(play.state.node);
+			bool won = (story.nodes[play.state.node].flags & Story::NodeWin) != 0;
+			std::cout << "Ended at " << end << (won ? " (win)" : play.ended() ? " (ending)" : "") << "." << std::endl;
+			if (!expect.empty() && end != expect) {
+				std::cerr << "Expected to end at " << expect << "." << std::endl;
+				return 1;
+			}
+			return 0;
+		}
+
+		//random play:
+		std::mt19937 mt(seed);
+		uint64_t transitions = 0;
+		uint64_t endings = 0;
+		uint64_t wins = 0;
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint64_t step = 0; step < steps; ++step) {
+			play.tick(1.0f);
+			uint32_t r = mt();
+			if (play.choose(Story::Side(r & 1)) != Story::Invalid) {
+				transitions += 1;
+			}
+			if (play.ended()) {
+				endings += 1;
+				if (story.nodes[play.state.node].flags & Story::NodeWin) wins += 1;
+				play.restart();
+			}
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		double seconds = std::chrono::duration< double >(after - before).count();
+
+		std::cout << "story-sim: " << steps << " random steps (seed " << seed << ") in " << seconds << " s." << std::endl;
+		std::cout << "  " << transitions << " transitions, " << endings << " endings (" << wins << " wins)" << std::endl;
+		std::cout << "  " << (steps / seconds / 1e6) << " M steps/s, " << (transitions / seconds / 1e6) << " M transitions/s" << std::endl;
+		std::cout << "  (final state: " << node_name(play.state.node) << ", bits " << play.state.bits << ")" << std::endl;
+	} catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
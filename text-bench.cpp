@@ -0,0 +1,147 @@
+//Microbenchmark for the CPU side of PlayMode's text drawing.
+// Compares a frame's worth of text work done the old way (shape with HarfBuzz
+// and load + render every glyph with FreeType, every frame) against the cached
+// way (ShapeCache lookup + GlyphAtlas metrics lookup, rasterizing only on miss).
+//
+// Runs without a window or GL context: GlyphAtlas::get_texture() is never called.
+//
+// usage: text-bench [frames]
+
+#include "GlyphAtlas.hpp"
+#include "ShapeCache.hpp"
+#include "StringPool.hpp"
+#include "data_path.hpp"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <hb.h>
+#include <hb-ft.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	uint32_t frames = 2000;
+	if (argc > 1) frames = uint32_t(std::stoul(argv[1]));
+
+	//the four strings PlayMode draws on its first screen, plus a long result string:
+	std::vector< std::string > const strings = {
+		"You are in the prison. What do you do to escape?",
+		"Dig a tunnel.",
+		"Call the guard.",
+		"Good luck!",
+		"Your crewmate is locked up. You use your key to free him.",
+	};
+
+	uint32_t const FontSize = 48; //matches PlayMode::GlyphSize
+
+	FT_Library ft_library;
+	FT_Face ft_face;
+	if (FT_Init_FreeType(&ft_library) != 0) {
+		std::cerr << "Failed to initialize FreeType." << std::endl;
+		return 1;
+	}
+	if (FT_New_Face(ft_library, data_path("dist/PTSerif-Italic.ttf").c_str(), 0, &ft_face) != 0) {
+		std::cerr << "Failed to load 'dist/PTSerif-Italic.ttf'." << std::endl;
+		return 1;
+	}
+	FT_Set_Char_Size(ft_face, FontSize * 64, FontSize * 64, 0, 0);
+	hb_font_t *hb_font = hb_ft_font_create(ft_face, NULL);
+
+	//positions are accumulated into 'checksum' so the optimizer can't skip work:
+	float checksum = 0.0f;
+	auto place = [&checksum](glm::vec2 const &min, glm::vec2 const &size) {
+		checksum += min.x + min.y + size.x + size.y;
+	};
+
+	//------ before: shape + rasterize everything, every frame ------
+	double before_seconds = 0.0;
+	{
+		hb_buffer_t *hb_buffer = hb_buffer_create();
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			for (auto const &txt : strings) {
+				hb_buffer_clear_contents(hb_buffer);
+				hb_buffer_add_utf8(hb_buffer, txt.c_str(), -1, 0, -1);
+				hb_buffer_guess_segment_properties(hb_buffer);
+				hb_shape(hb_font, hb_buffer, NULL, 0);
+
+				uint32_t len = hb_buffer_get_length(hb_buffer);
+				hb_glyph_info_t *infos = hb_buffer_get_glyph_infos(hb_buffer, NULL);
+				hb_glyph_position_t *positions = hb_buffer_get_glyph_positions(hb_buffer, NULL);
+
+				glm::vec2 cursor = glm::vec2(0.0f);
+				for (uint32_t i = 0; i < len; ++i) {
+					FT_Load_Glyph(ft_face, infos[i].codepoint, FT_LOAD_DEFAULT);
+					FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+					FT_GlyphSlot slot = ft_face->glyph;
+					place(
+						cursor + glm::vec2(slot->bitmap_left, slot->bitmap_top - int32_t(slot->bitmap.rows)),
+						glm::vec2(slot->bitmap.width, slot->bitmap.rows)
+					);
+					cursor += glm::vec2(positions[i].x_advance >> 6, positions[i].y_advance >> 6);
+				}
+			}
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		before_seconds = std::chrono::duration< double >(after - before).count();
+		hb_buffer_destroy(hb_buffer);
+	}
+
+	//------ after: cached shaping + cached glyph metrics ------
+	double after_seconds = 0.0;
+	uint32_t rasterized = 0;
+	ShapeCache shape_cache;
+	{
+		GlyphAtlas glyph_atlas;
+		//(the game interns its strings once; the cache is keyed by their handles)
+		std::vector< StringPool::Handle > handles;
+		for (auto const &txt : strings) {
+			handles.emplace_back(string_pool.intern(txt));
+		}
+		auto before = std::chrono::high_resolution_clock::now();
+		for (uint32_t frame = 0; frame < frames; ++frame) {
+			for (StringPool::Handle txt : handles) {
+				ShapeCache::Run const &run = shape_cache.get(txt, hb_font, 0, FontSize);
+				glm::vec2 cursor = glm::vec2(0.0f);
+				for (auto const &shaped : run) {
+					GlyphAtlas::Glyph const *glyph = glyph_atlas.find(shaped.index);
+					if (!glyph) {
+						FT_Load_Glyph(ft_face, shaped.index, FT_LOAD_DEFAULT);
+						FT_Render_Glyph(ft_face->glyph, FT_RENDER_MODE_NORMAL);
+						FT_GlyphSlot slot = ft_face->glyph;
+						glyph = glyph_atlas.insert(shaped.index,
+							glm::uvec2(slot->bitmap.width, slot->bitmap.rows), slot->bitmap.buffer, slot->bitmap.pitch,
+							glm::ivec2(slot->bitmap_left, slot->bitmap_top),
+							glm::ivec2(slot->advance.x, slot->advance.y)
+						);
+						rasterized += 1;
+					}
+					place(
+						cursor + glm::vec2(glyph->bearing.x, glyph->bearing.y - int32_t(glyph->size.y)),
+						glm::vec2(glyph->size)
+					);
+					cursor += glm::vec2(shaped.advance.x >> 6, shaped.advance.y >> 6);
+				}
+			}
+		}
+		auto after = std::chrono::high_resolution_clock::now();
+		after_seconds = std::chrono::duration< double >(after - before).count();
+	}
+
+	std::cout << "text-bench: " << frames << " frames of " << strings.size() << " strings." << std::endl;
+	std::cout << "  before (shape + FreeType every frame): " << (before_seconds / frames * 1e6) << " us/frame" << std::endl;
+	std::cout << "  after  (cached shaping + metrics):     " << (after_seconds / frames * 1e6) << " us/frame"
+	          << " (" << rasterized << " glyphs rasterized, " << shape_cache.misses << " runs shaped)" << std::endl;
+	std::cout << "  speedup: " << (before_seconds / after_seconds) << "x" << std::endl;
+	std::cout << "  (checksum " << checksum << ")" << std::endl;
+
+	hb_font_destroy(hb_font);
+	FT_Done_Face(ft_face);
+	FT_Done_FreeType(ft_library);
+
+	return 0;
+}
@@ -0,0 +1,153 @@
+//Microbenchmark for Scene's world-matrix update.
+// Compares computing every transform's local-to-world and world-to-local matrices
+// the scalar glm way (make_local_to_parent / make_parent_to_local and a matrix
+// multiply per transform) against the batched kernel in world_matrices.cpp that
+// Scene::Transforms::update_world() uses, for 1k, 10k, and 100k transforms.
+// Then times the kernel split by depth level across 1, 2, 4, ... threads (up to
+// the hardware thread count, or the count given), checking that every thread
+// count gives exactly the same matrices.
+//
+// Hierarchies are random but scene-like: a mix of roots, long chains, and wide fans.
+//
+// usage: transform-bench [min-seconds-per-test] [max-threads]
+
+#include "Scene.hpp"
+#include "world_matrices.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//a random scene-like hierarchy of 'count' transforms:
+static void build(Scene::Transforms &transforms, uint32_t count, std::mt19937 &mt) {
+	std::uniform_real_distribution< float > unit(-1.0f, 1.0f);
+	std::vector< Scene::Transform > added;
+	added.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		Scene::Transform parent;
+		uint32_t pick = mt() % 8;
+		if (added.empty() || pick == 0) {
+			//root
+		} else if (pick < 4) {
+			parent = added.back(); //extend a chain
+		} else {
+			parent = added[mt() % added.size()]; //anywhere
+		}
+		Scene::Transform t = transforms.add("", parent);
+		transforms.set_position(t, glm::vec3(unit(mt), unit(mt), unit(mt)));
+		transforms.set_rotation(t, glm::normalize(glm::quat(unit(mt), unit(mt), unit(mt), unit(mt))));
+		transforms.set_scale(t, glm::vec3(1.0f + 0.1f * unit(mt), 1.0f + 0.1f * unit(mt), 1.0f + 0.1f * unit(mt)));
+		added.emplace_back(t);
+	}
+}
+
+int main(int argc, char **argv) {
+	double min_seconds = 0.25;
+	if (argc > 1) min_seconds = std::stod(argv[1]);
+	uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+	if (argc > 2) max_threads = uint32_t(std::stoul(argv[2]));
+
+	std::vector< uint32_t > thread_counts;
+	for (uint32_t threads = 1; threads < max_threads; threads *= 2) {
+		thread_counts.emplace_back(threads);
+	}
+	thread_counts.emplace_back(max_threads);
+
+	std::mt19937 mt(0xbe9c);
+
+	std::cout << "transform-bench: world matrices, glm path vs. batched kernel (" << world_matrices_width() << " transforms at a time)." << std::endl;
+
+	for (uint32_t count : { 1000u, 10000u, 100000u }) {
+		Scene::Transforms transforms;
+		build(transforms, count, mt);
+		transforms.sort(); //(group by depth, as Scene::load does)
+
+		//glm path: one transform at a time, in storage (parent-before-child) order:
+		std::vector< glm::mat4x3 > local_to_worlds(count), world_to_locals(count);
+		auto glm_path = [&]() {
+			for (uint32_t i = 0; i < count; ++i) {
+				Scene::Transform t = transforms.at(i);
+				glm::mat4x3 local_to_parent = transforms.make_local_to_parent(t);
+				glm::mat4x3 parent_to_local = transforms.make_parent_to_local(t);
+				uint32_t p = transforms.parents[i];
+				if (p == Scene::Transforms::None) {
+					local_to_worlds[i] = local_to_parent;
+					world_to_locals[i] = parent_to_local;
+				} else {
+					local_to_worlds[i] = local_to_worlds[p] * glm::mat4(local_to_parent);
+					world_to_locals[i] = parent_to_local * glm::mat4(world_to_locals[p]);
+				}
+			}
+		};
+
+		//kernel path: mark everything out of date, then update:
+		auto kernel_path = [&]() {
+			std::fill(transforms.dirty.begin(), transforms.dirty.end(), uint8_t(1));
+			update_world_matrices(count, transforms.positions.data(), transforms.rotations.data(), transforms.scales.data(), transforms.parents.data(),
+				transforms.dirty.data(), transforms.local_to_worlds.data(), transforms.world_to_locals.data());
+		};
+
+		//run 'fn' repeatedly for at least min_seconds; returns seconds per run:
+		auto time = [&](auto const &fn) {
+			uint32_t runs = 0;
+			auto before = std::chrono::high_resolution_clock::now();
+			double seconds = 0.0;
+			do {
+				fn();
+				runs += 1;
+				seconds = std::chrono::duration< double >(std::chrono::high_resolution_clock::now() - before).count();
+			} while (seconds < min_seconds);
+			return seconds / runs;
+		};
+
+		double glm_seconds = time(glm_path);
+		double kernel_seconds = time(kernel_path);
+
+		//the two paths should agree (to rounding):
+		float max_error = 0.0f;
+		for (uint32_t i = 0; i < count; ++i) {
+			for (uint32_t c = 0; c < 4; ++c) {
+				for (uint32_t r = 0; r < 3; ++r) {
+					max_error = std::max(max_error, std::abs(local_to_worlds[i][c][r] - transforms.local_to_worlds[i][c][r]));
+					max_error = std::max(max_error, std::abs(world_to_locals[i][c][r] - transforms.world_to_locals[i][c][r]));
+				}
+			}
+		}
+
+		std::cout << "  " << count << " transforms:" << std::endl;
+		std::cout << "    glm path: " << (glm_seconds / count * 1e9) << " ns/transform" << std::endl;
+		std::cout << "    kernel:   " << (kernel_seconds / count * 1e9) << " ns/transform"
+			<< " (speedup: " << (glm_seconds / kernel_seconds) << "x)" << std::endl;
+		std::cout << "    largest difference: " << max_error << std::endl;
+
+		//threaded kernel, one depth level at a time:
+		std::vector< glm::mat4x3 > const serial_local_to_worlds = transforms.local_to_worlds;
+		std::vector< glm::mat4x3 > const serial_world_to_locals = transforms.world_to_locals;
+		std::cout << "    (" << (transforms.levels.size() - 1) << " depth levels)" << std::endl;
+		for (uint32_t threads : thread_counts) {
+			WorkerPool pool(threads);
+			auto threaded_path = [&]() {
+				std::fill(transforms.dirty.begin(), transforms.dirty.end(), uint8_t(1));
+				update_world_matrices(pool, uint32_t(transforms.levels.size()) - 1, transforms.levels.data(),
+					transforms.positions.data(), transforms.rotations.data(), transforms.scales.data(), transforms.parents.data(),
+					transforms.dirty.data(), transforms.local_to_worlds.data(), transforms.world_to_locals.data());
+			};
+			double threaded_seconds = time(threaded_path);
+			bool same = std::memcmp(serial_local_to_worlds.data(), transforms.local_to_worlds.data(), count * sizeof(glm::mat4x3)) == 0
+				&& std::memcmp(serial_world_to_locals.data(), transforms.world_to_locals.data(), count * sizeof(glm::mat4x3)) == 0;
+			std::cout << "    " << threads << " thread" << (threads == 1 ? ": " : "s:") << " " << (threaded_seconds / count * 1e9) << " ns/transform"
+				<< " (speedup over one-pass kernel: " << (kernel_seconds / threaded_seconds) << "x)"
+				<< (same ? "" : " -- RESULTS DIFFER") << std::endl;
+			if (!same) return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,269 @@
+#include "world_matrices.hpp"
+
+#include "WorkerPool.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WORLD_MATRICES_AVX2
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define WORLD_MATRICES_SSE
+#endif
+
+//-------------------------
+//Lane types: the transform math below is written once and runs on 1 (scalar), 4 (SSE), or 8 (AVX2)
+// transforms at a time. Each provides +, -, *, / and a "1/x, or 0 if x is 0" with plain IEEE
+// arithmetic (no fused multiply-add), so all of them give the same results.
+
+struct Lanes1 {
+	static constexpr uint32_t Width = 1;
+	float v;
+	static Lanes1 gather(float const * const from[1], uint32_t k) { return Lanes1{ from[0][k] }; }
+	void store(float *to) const { *to = v; }
+};
+static inline Lanes1 operator+(Lanes1 a, Lanes1 b) { return Lanes1{ a.v + b.v }; }
+static inline Lanes1 operator-(Lanes1 a, Lanes1 b) { return Lanes1{ a.v - b.v }; }
+static inline Lanes1 operator*(Lanes1 a, Lanes1 b) { return Lanes1{ a.v * b.v }; }
+static inline Lanes1 operator/(Lanes1 a, Lanes1 b) { return Lanes1{ a.v / b.v }; }
+static inline Lanes1 splat(Lanes1, float f) { return Lanes1{ f }; }
+static inline Lanes1 recip_or_zero(Lanes1 a) { return Lanes1{ a.v == 0.0f ? 0.0f : 1.0f / a.v }; }
+
+#if defined(WORLD_MATRICES_SSE)
+struct Lanes4 {
+	static constexpr uint32_t Width = 4;
+	__m128 v;
+	static Lanes4 gather(float const * const from[4], uint32_t k) { return Lanes4{ _mm_set_ps(from[3][k], from[2][k], from[1][k], from[0][k]) }; }
+	void store(float *to) const { _mm_store_ps(to, v); }
+};
+static inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return Lanes4{ _mm_add_ps(a.v, b.v) }; }
+static inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return Lanes4{ _mm_sub_ps(a.v, b.v) }; }
+static inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return Lanes4{ _mm_mul_ps(a.v, b.v) }; }
+static inline Lanes4 operator/(Lanes4 a, Lanes4 b) { return Lanes4{ _mm_div_ps(a.v, b.v) }; }
+static inline Lanes4 splat(Lanes4, float f) { return Lanes4{ _mm_set1_ps(f) }; }
+static inline Lanes4 recip_or_zero(Lanes4 a) {
+	__m128 zero = _mm_setzero_ps();
+	return Lanes4{ _mm_andnot_ps(_mm_cmpeq_ps(a.v, zero), _mm_div_ps(_mm_set1_ps(1.0f), a.v)) };
+}
+typedef Lanes4 Lanes;
+#elif defined(WORLD_MATRICES_AVX2)
+struct Lanes8 {
+	static constexpr uint32_t Width = 8;
+	__m256 v;
+	static Lanes8 gather(float const * const from[8], uint32_t k) {
+		return Lanes8{ _mm256_set_ps(from[7][k], from[6][k], from[5][k], from[4][k], from[3][k], from[2][k], from[1][k], from[0][k]) };
+	}
+	void store(float *to) const { _mm256_store_ps(to, v); }
+};
+static inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return Lanes8{ _mm256_add_ps(a.v, b.v) }; }
+static inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return Lanes8{ _mm256_sub_ps(a.v, b.v) }; }
+static inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return Lanes8{ _mm256_mul_ps(a.v, b.v) }; }
+static inline Lanes8 operator/(Lanes8 a, Lanes8 b) { return Lanes8{ _mm256_div_ps(a.v, b.v) }; }
+static inline Lanes8 splat(Lanes8, float f) { return Lanes8{ _mm256_set1_ps(f) }; }
+static inline Lanes8 recip_or_zero(Lanes8 a) {
+	__m256 zero = _mm256_setzero_ps();
+	return Lanes8{ _mm256_andnot_ps(_mm256_cmp_ps(a.v, zero, _CMP_EQ_OQ), _mm256_div_ps(_mm256_set1_ps(1.0f), a.v)) };
+}
+typedef Lanes8 Lanes;
+#else
+typedef Lanes1 Lanes;
+#endif
+
+uint32_t world_matrices_width() {
+	return Lanes::Width;
+}
+
+//-------------------------
+//Matrices are 4x3, column-major (as in glm::mat4x3): element [c*3+r] is column c, row r.
+
+//local-to-parent and parent-to-local matrices from position 'p', rotation 'q' (x,y,z,w), and scale 's':
+// (same math as Scene::Transforms::make_local_to_parent / make_parent_to_local)
+template< typename F >
+static void local_matrices(F const p[3], F const q[4], F const s[3], F local_to_parent[12], F parent_to_local[12]) {
+	F one = splat(F(), 1.0f);
+	F two = splat(F(), 2.0f);
+
+	//rotation matrix of quaternion (q.x, q.y, q.z, q.w), as glm::mat3_cast:
+	auto rotation = [&](F x, F y, F z, F w, F rot[9]) {
+		F xx = x * x, yy = y * y, zz = z * z;
+		F xz = x * z, xy = x * y, yz = y * z;
+		F wx = w * x, wy = w * y, wz = w * z;
+		rot[0] = one - two * (yy + zz); rot[1] = two * (xy + wz); rot[2] = two * (xz - wy);
+		rot[3] = two * (xy - wz); rot[4] = one - two * (xx + zz); rot[5] = two * (yz + wx);
+		rot[6] = two * (xz + wy); rot[7] = two * (yz - wx); rot[8] = one - two * (xx + yy);
+	};
+
+	//translate * rotate * scale (scaling the columns means scale happens before rotation):
+	F rot[9];
+	rotation(q[0], q[1], q[2], q[3], rot);
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (uint32_t r = 0; r < 3; ++r) {
+			local_to_parent[c*3+r] = rot[c*3+r] * s[c];
+		}
+	}
+	for (uint32_t r = 0; r < 3; ++r) {
+		local_to_parent[9+r] = p[r];
+	}
+
+	//1/scale * rotate^-1 * translate^-1:
+	// (inverse rotation is the conjugate quaternion over its squared length, as glm::inverse)
+	F len2 = (q[0] * q[0] + q[1] * q[1]) + (q[2] * q[2] + q[3] * q[3]);
+	F zero = splat(F(), 0.0f);
+	F inv_rot[9];
+	rotation((zero - q[0]) / len2, (zero - q[1]) / len2, (zero - q[2]) / len2, q[3] / len2, inv_rot);
+	//(taking care not to make NaN's, just a degenerate matrix, if scale is zero)
+	F inv_scale[3] = { recip_or_zero(s[0]), recip_or_zero(s[1]), recip_or_zero(s[2]) };
+	for (uint32_t c = 0; c < 3; ++c) {
+		for (uint32_t r = 0; r < 3; ++r) {
+			parent_to_local[c*3+r] = inv_rot[c*3+r] * inv_scale[r];
+		}
+	}
+	for (uint32_t r = 0; r < 3; ++r) {
+		parent_to_local[9+r] = zero - (parent_to_local[0*3+r] * p[0] + parent_to_local[1*3+r] * p[1] + parent_to_local[2*3+r] * p[2]);
+	}
+}
+
+//out = a * b, treating both as 4x4 matrices with a (0,0,0,1) last row:
+template< typename F >
+static void compose(F const a[12], F const b[12], F out[12]) {
+	for (uint32_t c = 0; c < 4; ++c) {
+		for (uint32_t r = 0; r < 3; ++r) {
+			F v = a[0*3+r] * b[c*3+0] + a[1*3+r] * b[c*3+1] + a[2*3+r] * b[c*3+2];
+			if (c == 3) v = v + a[9+r];
+			out[c*3+r] = v;
+		}
+	}
+}
+
+//compute world matrices for transforms [begin, begin + F::Width), none of which is another's parent,
+// writing out the dirty ones:
+template< typename F >
+static void update_batch(uint32_t begin,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t const *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals) {
+
+	constexpr uint32_t W = F::Width;
+	static float const Identity[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f };
+
+	//gather each lane's properties (and its parent's world matrices) into vectors:
+	// (roots compose with the identity, so they take the same path as everything else)
+	float const *p[W], *q[W], *s[W], *parent_l2w[W], *parent_w2l[W];
+	for (uint32_t l = 0; l < W; ++l) {
+		uint32_t i = begin + l;
+		p[l] = glm::value_ptr(positions[i]);
+		q[l] = &rotations[i].x; //(x, y, z, w)
+		s[l] = glm::value_ptr(scales[i]);
+		parent_l2w[l] = (parents[i] == -1U ? Identity : glm::value_ptr(local_to_worlds[parents[i]]));
+		parent_w2l[l] = (parents[i] == -1U ? Identity : glm::value_ptr(world_to_locals[parents[i]]));
+	}
+
+	F P[3], Q[4], S[3], parent_L2W[12], parent_W2L[12];
+	for (uint32_t k = 0; k < 3; ++k) {
+		P[k] = F::gather(p, k);
+		S[k] = F::gather(s, k);
+	}
+	for (uint32_t k = 0; k < 4; ++k) {
+		Q[k] = F::gather(q, k);
+	}
+	for (uint32_t k = 0; k < 12; ++k) {
+		parent_L2W[k] = F::gather(parent_l2w, k);
+		parent_W2L[k] = F::gather(parent_w2l, k);
+	}
+
+	F local_to_parent[12], parent_to_local[12], L2W[12], W2L[12];
+	local_matrices(P, Q, S, local_to_parent, parent_to_local);
+	compose(parent_L2W, local_to_parent, L2W);
+	compose(parent_to_local, parent_W2L, W2L);
+
+	//scatter results back to the dirty transforms:
+	alignas(32) float l2w[12][W], w2l[12][W];
+	for (uint32_t k = 0; k < 12; ++k) {
+		L2W[k].store(l2w[k]);
+		W2L[k].store(w2l[k]);
+	}
+	for (uint32_t l = 0; l < W; ++l) {
+		uint32_t i = begin + l;
+		if (!dirty[i]) continue;
+		float *out_l2w = glm::value_ptr(local_to_worlds[i]);
+		float *out_w2l = glm::value_ptr(world_to_locals[i]);
+		for (uint32_t k = 0; k < 12; ++k) {
+			out_l2w[k] = l2w[k][l];
+			out_w2l[k] = w2l[k][l];
+		}
+	}
+}
+
+//update transforms [begin, end), whose parents (if outside the range) are already up to date:
+static void update_range(uint32_t begin, uint32_t end,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals) {
+
+	//children of dirty transforms are dirty:
+	for (uint32_t i = begin; i < end; ++i) {
+		if (parents[i] != -1U && dirty[parents[i]]) dirty[i] = 1;
+	}
+
+	//full batches, where possible:
+	constexpr uint32_t W = Lanes::Width;
+	uint32_t i = begin;
+	for (; i + W <= end; i += W) {
+		bool any_dirty = false;
+		bool independent = true; //no transform in the batch is the parent of another
+		for (uint32_t l = 0; l < W; ++l) {
+			any_dirty = any_dirty || dirty[i+l];
+			independent = independent && (parents[i+l] == -1U || parents[i+l] < i);
+		}
+		if (!any_dirty) continue;
+		if (independent) {
+			update_batch< Lanes >(i, positions, rotations, scales, parents, dirty, local_to_worlds, world_to_locals);
+		} else {
+			//parent and child in the same batch: go one at a time, in order
+			for (uint32_t l = 0; l < W; ++l) {
+				if (!dirty[i+l]) continue;
+				update_batch< Lanes1 >(i+l, positions, rotations, scales, parents, dirty, local_to_worlds, world_to_locals);
+			}
+		}
+	}
+	//leftovers:
+	for (; i < end; ++i) {
+		if (!dirty[i]) continue;
+		update_batch< Lanes1 >(i, positions, rotations, scales, parents, dirty, local_to_worlds, world_to_locals);
+	}
+}
+
+void update_world_matrices(uint32_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals) {
+
+	update_range(0, count, positions, rotations, scales, parents, dirty, local_to_worlds, world_to_locals);
+
+	std::fill(dirty, dirty + count, uint8_t(0));
+}
+
+void update_world_matrices(WorkerPool &pool, uint32_t level_count, uint32_t const *levels,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals) {
+
+	uint32_t threads = pool.size();
+	pool.run([&](uint32_t thread) {
+		for (uint32_t level = 0; level < level_count; ++level) {
+			uint32_t begin = levels[level];
+			uint32_t end = levels[level + 1];
+			//split the level into (nearly) equal pieces, each a whole number of Chunk-sized pieces,
+			// so threads don't write to the same cache lines and batches stay full:
+			// (small levels end up all on the first few threads)
+			constexpr uint32_t Chunk = 16;
+			uint32_t chunks = (end - begin + Chunk - 1) / Chunk;
+			uint32_t first = begin + std::min(end - begin, (chunks * thread / threads) * Chunk);
+			uint32_t last = begin + std::min(end - begin, (chunks * (thread + 1) / threads) * Chunk);
+			update_range(first, last, positions, rotations, scales, parents, dirty, local_to_worlds, world_to_locals);
+			//everyone finishes this level before anyone starts on its children:
+			pool.barrier();
+		}
+	});
+
+	std::fill(dirty, dirty + levels[level_count], uint8_t(0));
+}
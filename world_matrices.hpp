@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+struct WorkerPool;
+
+//Bring world matrices up to date for 'count' transforms stored parent-before-child:
+// positions/rotations/scales: each transform's position/rotation/scale relative to its parent
+// parents: index of each transform's parent (or -1U for none); a parent's index is always less than its child's
+// dirty: transforms whose matrices are out of date; a transform whose parent is dirty is treated as dirty too.
+//  Only dirty transforms' matrices are written, and 'dirty' is all zero on return.
+// local_to_worlds/world_to_locals: per-transform output matrices (read for clean parents of dirty transforms)
+//
+//Works on several transforms at once (see world_matrices_width()); every width performs the same
+// operations in the same order, so results don't depend on which path a transform took.
+// (The 8-wide AVX2 path is used when building with AVX2 enabled, e.g. -mavx2 or /arch:AVX2; otherwise SSE.
+//  Letting the compiler contract multiply-adds into FMAs, e.g. -mfma, breaks the exact agreement.)
+void update_world_matrices(uint32_t count,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals);
+
+//The same, split across the threads of 'pool', for transforms sorted by depth in the hierarchy:
+// levels: level_count + 1 indices; transforms [levels[d], levels[d+1]) are the ones at depth d
+// Each level is divided among the threads, which meet at a barrier before starting the next level.
+// Results are exactly the same as the single-threaded version.
+void update_world_matrices(WorkerPool &pool, uint32_t level_count, uint32_t const *levels,
+	glm::vec3 const *positions, glm::quat const *rotations, glm::vec3 const *scales, uint32_t const *parents,
+	uint8_t *dirty, glm::mat4x3 *local_to_worlds, glm::mat4x3 *world_to_locals);
+
+//number of transforms update_world_matrices() handles at once in this build (8: AVX2, 4: SSE, 1: scalar):
+uint32_t world_matrices_width();